@@ -7,6 +7,7 @@
 #include "threads/io.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -87,6 +88,7 @@ static void identify_ata_device (struct disk *);
 static void select_sector (struct disk *, disk_sector_t);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
+static void input_sector_partial (struct channel *, void *, size_t, size_t);
 static void output_sector (struct channel *, const void *);
 
 static void wait_until_idle (const struct disk *);
@@ -96,6 +98,13 @@ static void select_device_wait (const struct disk *);
 
 static void interrupt_handler (struct intr_frame *);
 
+/* Identifies D and the direction of a transfer in disk trace
+   events. */
+static inline uint64_t
+disk_trace_id (const struct disk *d, bool write) {
+	return TRACE_DISK_ID (d->channel - channels, d->dev_no, write);
+}
+
 /* Initialize the disk subsystem and detect disks. */
 void
 disk_init (void) {
@@ -217,8 +226,10 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
 	c = d->channel;
 	lock_acquire (&c->lock);
 	select_sector (d, sec_no);
+	trace_event (TRACE_DISK_ISSUE, sec_no, disk_trace_id (d, false));
 	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
 	sema_down (&c->completion_wait);
+	trace_event (TRACE_DISK_DONE, sec_no, disk_trace_id (d, false));
 	if (!wait_while_busy (d))
 		PANIC ("%s: disk read failed, sector=%" PRDSNu, d->name, sec_no);
 	input_sector (c, buffer);
@@ -226,6 +237,34 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
 	lock_release (&c->lock);
 }
 
+/* Reads SIZE bytes starting at byte offset OFS within sector
+   SEC_NO of disk D directly into BUFFER, which need only have
+   room for SIZE bytes.  The rest of the sector is drained from
+   the controller and discarded, so no bounce buffer is needed
+   to satisfy a read that does not cover a whole sector. */
+void
+disk_read_partial (struct disk *d, disk_sector_t sec_no, void *buffer,
+		size_t ofs, size_t size) {
+	struct channel *c;
+
+	ASSERT (d != NULL);
+	ASSERT (buffer != NULL);
+	ASSERT (ofs + size <= DISK_SECTOR_SIZE);
+
+	c = d->channel;
+	lock_acquire (&c->lock);
+	select_sector (d, sec_no);
+	trace_event (TRACE_DISK_ISSUE, sec_no, disk_trace_id (d, false));
+	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
+	sema_down (&c->completion_wait);
+	trace_event (TRACE_DISK_DONE, sec_no, disk_trace_id (d, false));
+	if (!wait_while_busy (d))
+		PANIC ("%s: disk read failed, sector=%" PRDSNu, d->name, sec_no);
+	input_sector_partial (c, buffer, ofs, size);
+	d->read_cnt++;
+	lock_release (&c->lock);
+}
+
 /* Write sector SEC_NO to disk D from BUFFER, which must contain
    DISK_SECTOR_SIZE bytes.  Returns after the disk has
    acknowledged receiving the data.
@@ -241,11 +280,13 @@ disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
 	c = d->channel;
 	lock_acquire (&c->lock);
 	select_sector (d, sec_no);
+	trace_event (TRACE_DISK_ISSUE, sec_no, disk_trace_id (d, true));
 	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
 	if (!wait_while_busy (d))
 		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
 	output_sector (c, buffer);
 	sema_down (&c->completion_wait);
+	trace_event (TRACE_DISK_DONE, sec_no, disk_trace_id (d, true));
 	d->write_cnt++;
 	lock_release (&c->lock);
 }
@@ -439,6 +480,51 @@ input_sector (struct channel *c, void *sector) {
 	insw (reg_data (c), sector, DISK_SECTOR_SIZE / 2);
 }
 
+/* Reads a sector from channel C's data register in PIO mode,
+   storing only the SIZE bytes that start at byte OFS into
+   BUFFER.  The data register is 16 bits wide, so an odd OFS or
+   an odd end splits a word between the discarded and the kept
+   part of the sector. */
+static void
+input_sector_partial (struct channel *c, void *buffer, size_t ofs,
+		size_t size) {
+	uint8_t *dst = buffer;
+	size_t word = 0;
+	size_t words;
+	uint16_t data;
+
+	/* Skip the words entirely before OFS. */
+	for (; word < ofs / 2; word++)
+		inw (reg_data (c));
+
+	/* Leading odd byte. */
+	if ((ofs & 1) && size > 0) {
+		data = inw (reg_data (c));
+		word++;
+		*dst++ = data >> 8;
+		size--;
+	}
+
+	/* Whole words go straight into the destination. */
+	words = size / 2;
+	if (words > 0) {
+		insw (reg_data (c), dst, words);
+		word += words;
+		dst += words * 2;
+	}
+
+	/* Trailing odd byte. */
+	if (size & 1) {
+		data = inw (reg_data (c));
+		word++;
+		*dst = data & 0xff;
+	}
+
+	/* Drain the rest of the sector. */
+	for (; word < DISK_SECTOR_SIZE / 2; word++)
+		inw (reg_data (c));
+}
+
 /* Writes SECTOR to channel C's data register in PIO mode.
    SECTOR must contain DISK_SECTOR_SIZE bytes. */
 static void
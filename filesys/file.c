@@ -21,6 +21,7 @@ file_open (struct inode *inode) {
 		file->inode = inode;
 		file->pos = 0;
 		file->deny_write = false;
+		file->ref_cnt = 1;
 		return file;
 	} else {
 		inode_close (inode);
@@ -49,10 +50,19 @@ file_duplicate (struct file *file) {
 	return nfile;
 }
 
-/* Closes FILE. */
+/* Adds a reference to FILE, so that it can be installed under a
+ * second file descriptor sharing its position, and returns FILE. */
+struct file *
+file_share (struct file *file) {
+	file->ref_cnt++;
+	return file;
+}
+
+/* Drops a reference to FILE, closing it once the last one is
+ * gone. */
 void
 file_close (struct file *file) {
-	if (file != NULL) {
+	if (file != NULL && --file->ref_cnt == 0) {
 		file_allow_write (file);
 		inode_close (file->inode);
 		free (file);
@@ -6,6 +6,7 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -33,8 +34,9 @@ struct inode {
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+	unsigned write_cnt;                 /* Bumped by each write that lands. */
+	struct rwlock lock;                 /* Readers share, writers exclude. */
 	struct inode_disk data;             /* Inode content. */
-	
 };
 
 /* Returns the disk sector that contains byte offset POS within
@@ -54,10 +56,14 @@ byte_to_sector (const struct inode *inode, off_t pos) {
  * returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Protects open_inodes and every inode's open_cnt. */
+static struct lock open_inodes_lock;
+
 /* Initializes the inode module. */
 void
 inode_init (void) {
 	list_init (&open_inodes);
+	lock_init (&open_inodes_lock);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -104,36 +110,48 @@ struct inode *
 inode_open (disk_sector_t sector) {
 	struct list_elem *e;
 	struct inode *inode;
+
+	lock_acquire (&open_inodes_lock);
 	/* Check whether this inode is already open. */
 	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
 			e = list_next (e)) {
 		inode = list_entry (e, struct inode, elem);
 		if (inode->sector == sector) {
-			inode_reopen (inode);
+			inode->open_cnt++;
+			lock_release (&open_inodes_lock);
 			return inode; 
 		}
 	}
 
 	/* Allocate memory. */
 	inode = malloc (sizeof *inode);
-	if (inode == NULL)
+	if (inode == NULL) {
+		lock_release (&open_inodes_lock);
 		return NULL;
+	}
 
-	/* Initialize. */
+	/* Initialize.  The disk read stays under the list lock so that a
+	 * concurrent opener of the same sector never sees stale data. */
 	list_push_front (&open_inodes, &inode->elem);
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
+	inode->write_cnt = 0;
 	inode->removed = false;
+	rwlock_init (&inode->lock);
 	disk_read (filesys_disk, inode->sector, &inode->data);
+	lock_release (&open_inodes_lock);
 	return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire (&open_inodes_lock);
 		inode->open_cnt++;
+		lock_release (&open_inodes_lock);
+	}
 	return inode;
 }
 
@@ -153,9 +171,11 @@ inode_close (struct inode *inode) {
 		return;
 
 	/* Release resources if this was the last opener. */
+	lock_acquire (&open_inodes_lock);
 	if (--inode->open_cnt == 0) {
 		/* Remove from inode list and release lock. */
 		list_remove (&inode->elem);
+		lock_release (&open_inodes_lock);
 
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
@@ -165,7 +185,8 @@ inode_close (struct inode *inode) {
 		}
 
 		free (inode); 
-	}
+	} else
+		lock_release (&open_inodes_lock);
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -178,13 +199,16 @@ inode_remove (struct inode *inode) {
 
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
  * Returns the number of bytes actually read, which may be less
- * than SIZE if an error occurs or end of file is reached. */
+ * than SIZE if an error occurs or end of file is reached.
+ * Sector data is transferred straight into BUFFER, including for
+ * sectors only partly covered by the read, so a user buffer must
+ * be resident (see vm_pin_buffer()) before calling this. */
 off_t
 inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	uint8_t *buffer = buffer_;
 	off_t bytes_read = 0;
-	uint8_t *bounce = NULL;
 
+	rwlock_acquire_read (&inode->lock);
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -204,15 +228,10 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 			/* Read full sector directly into caller's buffer. */
 			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
 		} else {
-			/* Read sector into bounce buffer, then partially copy
-			 * into caller's buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-			disk_read (filesys_disk, sector_idx, bounce);
-			memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
+			/* Read just the wanted part of the sector into the
+			 * caller's buffer. */
+			disk_read_partial (filesys_disk, sector_idx, buffer + bytes_read,
+					sector_ofs, chunk_size);
 		}
 
 		/* Advance. */
@@ -220,7 +239,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
-	free (bounce);
+	rwlock_release_read (&inode->lock);
 
 	return bytes_read;
 }
@@ -237,8 +256,11 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	off_t bytes_written = 0;
 	uint8_t *bounce = NULL;
 
-	if (inode->deny_write_cnt)
+	rwlock_acquire_write (&inode->lock);
+	if (inode->deny_write_cnt) {
+		rwlock_release_write (&inode->lock);
 		return 0;
+	}
 
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
@@ -282,6 +304,9 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
+	if (bytes_written > 0)
+		inode->write_cnt++;
+	rwlock_release_write (&inode->lock);
 	free (bounce);
 
 	return bytes_written;
@@ -292,8 +317,10 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	void
 inode_deny_write (struct inode *inode) 
 {
+	rwlock_acquire_write (&inode->lock);
 	inode->deny_write_cnt++;
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
+	rwlock_release_write (&inode->lock);
 }
 
 /* Re-enables writes to INODE.
@@ -301,9 +328,25 @@ inode_deny_write (struct inode *inode)
  * inode_deny_write() on the inode, before closing the inode. */
 void
 inode_allow_write (struct inode *inode) {
+	rwlock_acquire_write (&inode->lock);
 	ASSERT (inode->deny_write_cnt > 0);
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
 	inode->deny_write_cnt--;
+	rwlock_release_write (&inode->lock);
+}
+
+/* Returns true if INODE has been removed and will be freed on its
+ * last close. */
+bool
+inode_is_removed (const struct inode *inode) {
+	return inode->removed;
+}
+
+/* Returns a count that changes whenever INODE's data is written,
+ * so that a cache of its contents can tell it has gone stale. */
+unsigned
+inode_write_count (const struct inode *inode) {
+	return inode->write_cnt;
 }
 
 /* Returns the length, in bytes, of INODE's data. */
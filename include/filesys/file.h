@@ -9,6 +9,8 @@ struct file {
 	struct inode *inode;        /* File's inode. */
 	off_t pos;                  /* Current position. */
 	bool deny_write;            /* Has file_deny_write() been called? */
+	int ref_cnt;                /* Descriptors sharing this file. */
+	struct file *fork_copy;     /* Its copy in the child, during fork. */
 };
 
 struct inode;
@@ -17,6 +19,7 @@ struct inode;
 struct file *file_open (struct inode *);
 struct file *file_reopen (struct file *);
 struct file *file_duplicate (struct file *file);
+struct file *file_share (struct file *file);
 void file_close (struct file *);
 struct inode *file_get_inode (struct file *);
 
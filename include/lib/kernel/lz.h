@@ -0,0 +1,29 @@
+#ifndef __LIB_KERNEL_LZ_H
+#define __LIB_KERNEL_LZ_H
+
+/* Fast LZ77-family compression, in the style of LZ4.
+ *
+ * The output is a series of sequences.  Each starts with a token
+ * byte whose high nibble is a literal count and whose low nibble is
+ * a match length minus LZ_MIN_MATCH; a nibble of 15 is continued in
+ * following bytes, each added in, until one is less than 255.  Then
+ * come the literals, then a 2-byte little-endian match offset.  The
+ * last sequence has literals only.
+ *
+ * Inputs are limited to 64 kB.  Neither function allocates memory:
+ * the compressor keeps its match table in a caller-supplied work
+ * area of LZ_WORK_SIZE bytes. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 11
+#define LZ_WORK_SIZE ((1 << LZ_HASH_BITS) * sizeof (uint16_t))
+
+size_t lz_compress (const void *src, size_t src_len,
+		void *dst, size_t dst_cap, void *work);
+size_t lz_decompress (const void *src, size_t src_len,
+		void *dst, size_t dst_cap);
+
+#endif /* lib/kernel/lz.h */
@@ -0,0 +1,97 @@
+#ifndef __LIB_KERNEL_OHASH_H
+#define __LIB_KERNEL_OHASH_H
+
+/* Open-addressing hash table.
+ *
+ * A companion to hash.h for tables that are searched far more
+ * often than they change.  Elements are looked up by a 64-bit
+ * key, which the table keeps next to the element pointer in a
+ * flat array of slots.  A lookup therefore walks a few adjacent
+ * slots, usually within one cache line, and touches no element
+ * but the one it returns.
+ *
+ * Collisions are resolved by linear probing with Robin Hood
+ * insertion: an element that has probed further from its home
+ * slot takes the place of one that has probed less.  This keeps
+ * probe sequences short and lets an unsuccessful search stop as
+ * soon as it meets an element closer to home than the key would
+ * be.  Deletion shifts the following elements back instead of
+ * leaving tombstones.
+ *
+ * The table doubles when it is 7/8 full.  Rather than moving every
+ * element at once, it keeps the old slot array and moves a few
+ * elements into the new one on each insertion or deletion; lookups
+ * search both arrays until the old one is empty.
+ *
+ * As with struct hash, each element embeds a struct ohash_elem,
+ * and ohash_entry() converts back to the outer structure.  The
+ * element's key is stored in the ohash_elem: set it before
+ * ohash_insert() and leave it alone while the element is in a
+ * table.  Keys must be unique within a table. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Open hash element. */
+struct ohash_elem {
+	uint64_t key;
+};
+
+/* Converts pointer to open hash element OHASH_ELEM into a pointer
+ * to the structure that OHASH_ELEM is embedded inside.  Supply the
+ * name of the outer structure STRUCT and the member name MEMBER of
+ * the open hash element. */
+#define ohash_entry(OHASH_ELEM, STRUCT, MEMBER)                 \
+	((STRUCT *) ((uint8_t *) &(OHASH_ELEM)->key             \
+		- offsetof (STRUCT, MEMBER.key)))
+
+/* Performs some operation on open hash element E. */
+typedef void ohash_action_func (struct ohash_elem *e);
+
+/* One slot: an element and a copy of its key. */
+struct ohash_slot {
+	uint64_t key;
+	struct ohash_elem *elem;    /* Null if the slot is empty. */
+};
+
+/* A slot array. */
+struct ohash_table {
+	struct ohash_slot *slots;   /* Array of `mask + 1' slots, or null. */
+	size_t mask;                /* Slot count minus 1; count is a power of 2. */
+	int bits;                   /* log2 of the slot count. */
+	size_t elem_cnt;            /* Number of elements in the array. */
+};
+
+/* Open hash table. */
+struct ohash {
+	struct ohash_table cur;     /* Receives new elements. */
+	struct ohash_table old;     /* Being drained into CUR, if not empty. */
+	size_t drain_pos;           /* Next slot of OLD to drain. */
+};
+
+/* Result of ohash_insert(). */
+enum ohash_insert_result {
+	OHASH_INSERTED,             /* The element was inserted. */
+	OHASH_DUPLICATE,            /* Its key was already in the table. */
+	OHASH_NO_MEMORY             /* The table is full and cannot grow. */
+};
+
+/* Basic life cycle. */
+bool ohash_init (struct ohash *);
+void ohash_clear (struct ohash *, ohash_action_func *);
+void ohash_destroy (struct ohash *, ohash_action_func *);
+
+/* Search, insertion, deletion. */
+enum ohash_insert_result ohash_insert (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_find (struct ohash *, uint64_t key);
+struct ohash_elem *ohash_delete (struct ohash *, struct ohash_elem *);
+
+/* Iteration. */
+void ohash_apply (struct ohash *, ohash_action_func *);
+
+/* Information. */
+size_t ohash_size (struct ohash *);
+bool ohash_empty (struct ohash *);
+
+#endif /* lib/kernel/ohash.h */
@@ -0,0 +1,46 @@
+#ifndef __LIB_RING_H
+#define __LIB_RING_H
+
+#include <stdint.h>
+
+/* Batched system call rings, shared between a user process and
+ * the kernel.  The process fills submission entries in a
+ * `struct ring_sq', each naming a system call and its arguments,
+ * and hands the whole batch to ring_enter().  The kernel runs
+ * them in order and posts one `struct ring_cqe' per entry to the
+ * `struct ring_cq'.
+ *
+ * HEAD and TAIL are free-running counters; an entry's slot is
+ * its counter modulo RING_ENTRIES.  The producer of a ring only
+ * advances TAIL, the consumer only advances HEAD. */
+
+#define RING_ENTRIES 64         /* Slots per ring, a power of 2. */
+
+/* A submitted system call. */
+struct ring_sqe {
+	int nr;                     /* SYS_* number. */
+	uint64_t args[4];           /* Arguments, as for syscall4(). */
+	uint64_t user_data;         /* Copied to the completion. */
+};
+
+/* A completed system call. */
+struct ring_cqe {
+	uint64_t user_data;         /* From the submission entry. */
+	int res;                    /* System call's return value. */
+};
+
+/* Submission ring, written by the process. */
+struct ring_sq {
+	unsigned head;              /* Next entry the kernel takes. */
+	unsigned tail;              /* Next free slot. */
+	struct ring_sqe sqes[RING_ENTRIES];
+};
+
+/* Completion ring, written by the kernel. */
+struct ring_cq {
+	unsigned head;              /* Next completion to reap. */
+	unsigned tail;              /* Next slot the kernel fills. */
+	struct ring_cqe cqes[RING_ENTRIES];
+};
+
+#endif /* lib/ring.h */
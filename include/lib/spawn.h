@@ -0,0 +1,17 @@
+#ifndef __LIB_SPAWN_H
+#define __LIB_SPAWN_H
+
+/* One descriptor for spawn() to set up in the new process.  The
+ * child starts with only the console open as fds 0 and 1; each
+ * action then installs a copy of the parent's PARENT_FD as the
+ * child's CHILD_FD, or closes CHILD_FD if PARENT_FD is -1.
+ * Shared by user programs and the kernel. */
+struct spawn_fd {
+	int parent_fd;
+	int child_fd;
+};
+
+/* Most actions a single spawn() call may carry. */
+#define SPAWN_FDS_MAX 16
+
+#endif /* lib/spawn.h */
@@ -36,6 +36,20 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Vectored and positional I/O. */
+	SYS_READV,                  /* Read into several buffers. */
+	SYS_WRITEV,                 /* Write from several buffers. */
+	SYS_PREAD,                  /* Read at an offset, leaving the position. */
+	SYS_PWRITE,                 /* Write at an offset, leaving the position. */
+
+	/* Batched submission. */
+	SYS_RING_SETUP,             /* Register submission/completion rings. */
+	SYS_RING_ENTER,             /* Run queued submissions. */
+
+	/* Process creation without fork. */
+	SYS_SPAWN,                  /* Start a new process from a file. */
+	SYS_VFORK,                  /* Clone, borrowing the address space. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,16 @@
+#ifndef __LIB_UIO_H
+#define __LIB_UIO_H
+
+#include <stddef.h>
+
+/* One buffer of a scatter/gather request, as passed to readv()
+ * and writev().  Shared by user programs and the kernel. */
+struct iovec {
+	void *iov_base;             /* Start of the buffer. */
+	size_t iov_len;             /* Size of the buffer in bytes. */
+};
+
+/* Most buffers a single readv() or writev() call may name. */
+#define IOV_MAX 64
+
+#endif /* lib/uio.h */
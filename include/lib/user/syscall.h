@@ -4,6 +4,9 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <uio.h>
+#include <ring.h>
+#include <spawn.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -24,7 +27,10 @@ typedef int off_t;
 void halt (void) NO_RETURN;
 void exit (int status) NO_RETURN;
 pid_t fork (const char *thread_name);
+pid_t vfork (const char *thread_name);
 int exec (const char *file);
+pid_t spawn (const char *file, char *const argv[],
+		const struct spawn_fd *fds, int fd_cnt);
 int wait (pid_t);
 bool create (const char *file, unsigned initial_size);
 bool remove (const char *file);
@@ -38,6 +44,14 @@ void close (int fd);
 
 int dup2(int oldfd, int newfd);
 
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int pread (int fd, void *buffer, unsigned length, off_t offset);
+int pwrite (int fd, const void *buffer, unsigned length, off_t offset);
+
+int ring_setup (struct ring_sq *sq, struct ring_cq *cq);
+int ring_enter (unsigned to_submit);
+
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
@@ -0,0 +1,43 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/synch.h"
+
+/* Scheduler state of a CPU: its run queue, under its own RQ_LOCK,
+   and its tick counters.
+
+   Only the boot CPU runs.  Starting the application processors
+   would take a real-mode trampoline, a GDT, TSS and stack per CPU,
+   local APIC IPIs for rescheduling and TLB shootdown, and above all
+   moving every subsystem that still excludes others by turning
+   interrupts off (swap, the file system, palloc, malloc) onto
+   locks that work across CPUs.  Until then BOOT_CPU is the only
+   instance, and spinlocks only need to keep interrupts off.
+
+   For the same reason there is no load balancing: stealing from
+   and rebalancing between run queues has nothing to work on until
+   there is a second queue. */
+struct cpu {
+	int id;                     /* CPU number, 0 for the boot CPU. */
+	struct thread *idle_thread; /* Runs when READY_LIST is empty. */
+
+	struct spinlock rq_lock;    /* Protects READY_LIST. */
+	struct list ready_list;     /* THREAD_READY threads, by priority. */
+	size_t ready_cnt;           /* Length of READY_LIST. */
+	unsigned thread_ticks;      /* # of timer ticks since last yield. */
+
+	/* Statistics. */
+	long long idle_ticks;       /* # of timer ticks spent idle. */
+	long long kernel_ticks;     /* # of timer ticks in kernel threads. */
+	long long user_ticks;       /* # of timer ticks in user programs. */
+};
+
+extern struct cpu boot_cpu;
+
+void cpu_init (void);
+struct cpu *this_cpu (void);
+
+#endif /* threads/cpu.h */
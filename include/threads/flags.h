@@ -9,4 +9,13 @@
 #define FLAG_AC    (1<<18)
 #define FLAG_NT    (1<<14)
 
+/* CR0 bits. */
+#define CR0_WP     (1<<16)  /* Read-only pages bind the kernel too. */
+
+/* CR4 bits. */
+#define CR4_PCIDE  (1<<17)  /* CR3 carries a process-context ID. */
+
+/* CPUID.1:ECX bits. */
+#define CPUID_1_ECX_PCID (1<<17)
+
 #endif /* threads/flags.h */
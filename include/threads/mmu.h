@@ -7,14 +7,23 @@
 
 typedef bool pte_for_each_func (uint64_t *pte, void *va, void *aux);
 
+/* A page directory entry with PTE_PS set maps a whole 2 MiB page. */
+#define HPAGE_SIZE (1UL << PDXSHIFT)
+#define HPAGE_PGCNT (HPAGE_SIZE / PGSIZE)
+
 uint64_t *pml4e_walk (uint64_t *pml4, const uint64_t va, int create);
 uint64_t *pml4_create (void);
 bool pml4_for_each (uint64_t *, pte_for_each_func *, void *);
 void pml4_destroy (uint64_t *pml4);
 void pml4_activate (uint64_t *pml4);
+bool pml4_is_active (uint64_t *pml4);
+void pcid_init (void);
 void *pml4_get_page (uint64_t *pml4, const void *upage);
 bool pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw);
-void pml4_clear_page (uint64_t *pml4, void *upage);
+bool pml4_clear_page (uint64_t *pml4, void *upage);
+bool pml4_set_huge_page (uint64_t *pml4, void *upage, void *kpage, bool rw);
+bool pml4_split_huge_page (uint64_t *pml4, void *upage);
+bool pml4_is_huge (uint64_t *pml4, const void *uaddr);
 bool pml4_is_dirty (uint64_t *pml4, const void *upage);
 void pml4_set_dirty (uint64_t *pml4, const void *upage, bool dirty);
 bool pml4_is_accessed (uint64_t *pml4, const void *upage);
@@ -0,0 +1,29 @@
+#ifndef THREADS_SWITCH_H
+#define THREADS_SWITCH_H
+
+#include <stdint.h>
+
+/* Saved stack pointer of a switched-out thread points to this.
+   switch_threads() pushes it, and pops it off the stack it
+   switches to. */
+struct switch_frame {
+	uint64_t r15;
+	uint64_t r14;
+	uint64_t r13;
+	uint64_t r12;
+	uint64_t rbp;
+	uint64_t rbx;
+	void (*rip) (void);         /* Return address. */
+};
+
+/* Saves the callee-saved registers on the current stack, stores
+   the stack pointer in *CUR_RSP, loads NEXT_RSP and restores the
+   registers saved there.  Returns in the thread that last called
+   it with NEXT_RSP's stack, or in switch_entry() for a new one. */
+void switch_threads (uint64_t *cur_rsp, uint64_t next_rsp);
+
+/* Where a new thread's first switch_threads() returns to.  Calls
+   the function in RBX with R12 and R13 as its two arguments. */
+void switch_entry (void);
+
+#endif /* threads/switch.h */
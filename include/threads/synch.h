@@ -3,6 +3,7 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include "threads/interrupt.h"
 
 /* A counting semaphore. */
 struct semaphore {
@@ -28,6 +29,52 @@ bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
+/* Spinlock.  Keeps interrupts off on the holding CPU and makes
+   other CPUs busy-wait, so it may be taken from an interrupt
+   handler or with interrupts already off.  Hold it only briefly
+   and never sleep while holding it. */
+struct spinlock {
+	volatile int locked;        /* Nonzero while held. */
+	struct cpu *holder;         /* CPU holding lock (for debugging). */
+	enum intr_level old_level;  /* Interrupt level to restore. */
+};
+
+void spin_init (struct spinlock *);
+void spin_lock (struct spinlock *);
+bool spin_try_lock (struct spinlock *);
+void spin_unlock (struct spinlock *);
+bool spin_held (const struct spinlock *);
+
+/* Reader-writer lock.  Any number of readers may hold it at
+   once, or a single writer.  A waiting writer keeps new readers
+   out, so writers cannot be starved by a stream of readers. */
+#define RWLOCK_HOLDERS 8        /* Readers tracked for donation. */
+
+/* A reader inside an rwlock, as far as donation goes. */
+struct rwlock_holder {
+	struct thread *thread;      /* Reader, or NULL if the slot is free. */
+	bool donated;               /* On THREAD's rw_donations? */
+	int donation;               /* Priority given by the draining writer. */
+	struct list_elem elem;      /* Element in THREAD's rw_donations. */
+};
+
+struct rwlock {
+	struct lock lock;           /* Held by the writer; readers pass through. */
+	unsigned readers;           /* Number of readers inside. */
+	bool writer_waiting;        /* Writer is draining readers. */
+	struct semaphore drain;     /* Upped by the last reader out. */
+	struct rwlock_holder holders[RWLOCK_HOLDERS]; /* Readers inside. */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+bool rwlock_try_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+bool rwlock_try_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_for_write (const struct rwlock *);
+
 /* Condition variable. */
 struct condition {
 	struct list waiters;        /* List of waiting threads. */
@@ -35,6 +35,7 @@ typedef int tid_t;
 
 #define FDT_PAGES 3
 #define FDCOUNT_LIMIT FDT_PAGES * (1 << 9)
+#define FDT_INIT_CNT 32 /* Slots in a new fd table; it doubles as needed. */
 
 /* A kernel thread or user process.
  *
@@ -108,9 +109,11 @@ struct thread
 	struct lock *wait_on_lock;
 	struct list donations;
 	struct list_elem donation_elem;
+	struct list rw_donations; /* struct rwlock_holder, from writers draining. */
 
-	struct file **fd_table;
-	int fd_idx;
+	struct file **fd_table; /* fd_cnt slots, grown on demand. */
+	int fd_cnt;
+	struct bitmap *fd_map;	/* Open fds, FDCOUNT_LIMIT bits. */
 
 	int is_user_prog;
 
@@ -127,6 +130,10 @@ struct thread
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
 	uint64_t *pml4; /* Page map level 4 */
+	struct ring_sq *ring_sq; /* Registered by ring_setup(), user memory. */
+	struct ring_cq *ring_cq;
+	struct thread *vfork_parent; /* Lent us its address space, if any. */
+	struct exec_image *exec_image; /* Executable we are running. */
 #endif
 #ifdef VM
 	/* Table for whole virtual memory owned by thread. */
@@ -136,7 +143,8 @@ struct thread
 #endif
 
 	/* Owned by thread.c. */
-	struct intr_frame tf; /* Information for switching */
+	uint64_t switch_rsp;  /* Saved stack pointer while switched out. */
+	struct cpu *cpu;      /* CPU whose run queue holds us. */
 	struct intr_frame ptf;
 
 	unsigned magic; /* Detects stack overflow. */
@@ -167,6 +175,8 @@ void thread_yield(void);
 
 int thread_get_priority(void);
 void thread_set_priority(int);
+void thread_raise_priority(struct thread *, int);
+void thread_refresh_priority(void);
 
 int thread_get_nice(void);
 void thread_set_nice(int);
@@ -0,0 +1,53 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdint.h>
+
+/* Kinds of trace events.  utils/pintos-trace knows these by
+   number, so add new ones only at the end. */
+enum trace_event {
+	TRACE_SCHEDULE,             /* ARG0: tid switched to, ARG1: old status. */
+	TRACE_PAGE_FAULT,           /* ARG0: fault address, ARG1: PF_* bits. */
+	TRACE_EVICT,                /* ARG0: victim user page, ARG1: kva. */
+	TRACE_SWAP_IN,              /* ARG0: user page, ARG1: kva. */
+	TRACE_SWAP_OUT,             /* ARG0: user page, ARG1: kva. */
+	TRACE_DISK_ISSUE,           /* ARG0: sector, ARG1: TRACE_DISK_ID(). */
+	TRACE_DISK_DONE,            /* ARG0: sector, ARG1: TRACE_DISK_ID(). */
+	TRACE_SYSCALL_ENTER,        /* ARG0: syscall number, ARG1: first arg. */
+	TRACE_SYSCALL_EXIT,         /* ARG0: syscall number, ARG1: result. */
+	TRACE_EVENT_CNT
+};
+
+/* ARG1 of disk events: channel, device and direction. */
+#define TRACE_DISK_ID(CHAN, DEV, WRITE) \
+	(((CHAN) << 1) | (DEV) | ((WRITE) ? 0x100 : 0))
+
+/* One logged event.  This is also the on-disk format written by
+   trace_dump(). */
+struct trace_record {
+	uint64_t tsc;               /* Time stamp counter. */
+	uint16_t event;             /* enum trace_event. */
+	uint16_t cpu;               /* CPU the event happened on. */
+	int32_t tid;                /* Thread that was running. */
+	uint64_t arg0;              /* Event-specific. */
+	uint64_t arg1;              /* Event-specific. */
+};
+
+/* Header at the start of a trace dump, followed by RECORD_CNT
+   records, oldest first. */
+#define TRACE_MAGIC 0x45435254  /* "TRCE". */
+struct trace_header {
+	uint32_t magic;             /* TRACE_MAGIC. */
+	uint16_t version;           /* 1. */
+	uint16_t record_size;       /* sizeof (struct trace_record). */
+	uint32_t record_cnt;        /* Records that follow. */
+	uint32_t reserved;
+	uint64_t tsc_hz;            /* Estimated time stamp counter rate. */
+	uint64_t lost_cnt;          /* Older records overwritten. */
+};
+
+void trace_init (void);
+void trace_event (enum trace_event, uint64_t arg0, uint64_t arg1);
+void trace_dump (char **argv);
+
+#endif /* threads/trace.h */
@@ -0,0 +1,48 @@
+#ifndef USERPROG_EXEC_CACHE_H
+#define USERPROG_EXEC_CACHE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "filesys/file.h"
+
+struct text_frame;
+
+/* One PT_LOAD segment, already validated and rounded to pages. */
+struct exec_segment {
+	off_t file_page;            /* Page-aligned offset in the file. */
+	uint8_t *mem_page;          /* Page-aligned user address. */
+	uint32_t read_bytes;        /* Bytes read from the file... */
+	uint32_t zero_bytes;        /* ...then this many zeros. */
+	bool writable;
+	struct text_frame *text;    /* Shared pages if read-only, else NULL. */
+};
+
+/* An executable whose ELF headers have been parsed, kept so that
+ * the next exec() of the same inode can skip parsing, and so that
+ * processes running it at the same time share its text. */
+struct exec_image {
+	struct list_elem elem;      /* In the cache while `cached'. */
+	struct file *file;          /* Private handle; keeps the inode open. */
+	unsigned write_cnt;         /* inode_write_count() when parsed. */
+	bool cached;
+	int users;                  /* Processes running this image. */
+	uint64_t entry;             /* Entry point. */
+	int seg_cnt;
+	struct exec_segment segs[]; /* Loadable segments, in file order. */
+};
+
+void exec_cache_init (void);
+struct exec_image *exec_cache_get (struct file *file);
+struct exec_image *exec_cache_add (struct exec_image *image);
+
+struct exec_image *exec_image_create (struct file *file, uint64_t entry,
+		int max_segs);
+bool exec_image_add_segment (struct exec_image *image, off_t file_page,
+		uint8_t *mem_page, uint32_t read_bytes, uint32_t zero_bytes,
+		bool writable);
+void exec_image_discard (struct exec_image *image);
+struct exec_image *exec_image_ref (struct exec_image *image);
+void exec_image_release (struct exec_image *image);
+
+#endif /* userprog/exec-cache.h */
@@ -3,9 +3,13 @@
 
 #include "threads/thread.h"
 
+struct spawn_fd;
+
 tid_t process_create_initd (const char *file_name);
 tid_t process_fork (const char *name, struct intr_frame *if_);
+tid_t process_vfork (const char *name);
 int process_exec (void *f_name);
+tid_t process_spawn (char *cmd_line, const struct spawn_fd *fds, int fd_cnt);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (struct thread *next);
@@ -17,9 +17,19 @@ struct res_data
 };
 void syscall_init (void);
 
-void check_addr(const uint64_t *addr);
+/* fd table entries for the console.  They stand in for open files
+ * so that the console can be closed and dup2()'d like any other
+ * descriptor, but are never passed to the file layer. */
+#define STDIN_FILE ((struct file *) 1)
+#define STDOUT_FILE ((struct file *) 2)
+#define is_console_file(FILE) ((FILE) == STDIN_FILE || (FILE) == STDOUT_FILE)
+
 struct file *find_file_by_Fd(int fd);
 int add_file_to_fdt(struct file *file);
+bool fdt_init(struct thread *t);
+bool fdt_install(struct thread *t, int fd, struct file *file);
+bool fdt_duplicate(struct thread *dst, struct thread *src);
+void fdt_destroy(struct thread *t);
 
 
 void call_close(struct res_data res_data);
@@ -32,12 +42,21 @@ int call_read(struct res_data res_data);
 int call_filesize(struct res_data res_data);
 int call_wait(struct res_data res_data);
 int call_fork (struct res_data res_data);
+int call_vfork (struct res_data res_data);
 int call_exec (struct res_data res_data);
 bool call_remove(struct res_data res_data);
 void call_seek(struct res_data res_data);
 unsigned call_tell(struct res_data res_data);
 void * call_mmap(struct res_data res_data);
 void call_munmap (struct res_data res_data);
+int call_readv(struct res_data res_data);
+int call_writev(struct res_data res_data);
+int call_pread(struct res_data res_data);
+int call_pwrite(struct res_data res_data);
+int call_ring_setup(struct res_data res_data);
+int call_ring_enter(struct res_data res_data);
+int call_dup2(struct res_data res_data);
+int call_spawn(struct res_data res_data);
 
 void exit(uint64_t status);
 
@@ -0,0 +1,20 @@
+#ifndef USERPROG_UACCESS_H
+#define USERPROG_UACCESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "threads/interrupt.h"
+
+/* Accessors for user memory.  They touch the user address directly
+ * and let the page fault handler resolve it as usual.  A fault the
+ * handler cannot resolve resumes at a fixup recorded in the kernel's
+ * exception table, and the accessor reports failure instead of the
+ * kernel panicking.  There is no page-table walk up front. */
+
+size_t copy_from_user (void *dst, const void *usrc, size_t size);
+size_t copy_to_user (void *udst, const void *src, size_t size);
+long strncpy_from_user (char *dst, const char *usrc, size_t size);
+
+bool uaccess_fixup (struct intr_frame *);
+
+#endif /* userprog/uaccess.h */
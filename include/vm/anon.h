@@ -6,13 +6,17 @@
 
 struct page;
 enum vm_type;
+struct zswap_entry;
 
 struct anon_page {
     // 스왑디스크 어디에 있는지...
     disk_sector_t disk_sec;
+    struct zswap_entry *zentry;   /* Compressed copy, if swapped to RAM. */
 };
 
 void vm_anon_init (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
+void anon_swap_write (struct page *page, const void *kva, uint64_t *pml4);
+void anon_print_stats (void);
 
 #endif
@@ -0,0 +1,12 @@
+#ifndef VM_KSM_H
+#define VM_KSM_H
+
+struct frame;
+
+void vm_ksm_init (void);
+void ksm_put (struct frame *frame);
+void ksm_break (struct frame *frame);
+void ksm_forget (struct frame *frame);
+void ksm_print_stats (void);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef VM_TEXT_H
+#define VM_TEXT_H
+#include "filesys/file.h"
+#include "vm/vm.h"
+
+struct page;
+struct text_frame;
+enum vm_type;
+
+struct text_page {
+	struct text_frame *shared;
+};
+
+void vm_text_init (void);
+bool vm_alloc_text_page (void *upage, struct text_frame *shared);
+bool text_claim_page (struct page *page);
+void text_frame_free (struct text_frame *text);
+
+#endif
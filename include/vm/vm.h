@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include "threads/palloc.h"
 #include "hash.h"
+#include "ohash.h"
 #include <bitmap.h>
 
 enum vm_type {
@@ -14,6 +15,8 @@ enum vm_type {
 	VM_FILE = 2,
 	/* page that hold the page cache, for project 4 */
 	VM_PAGE_CACHE = 3,
+	/* read-only program text, shared by every process running it */
+	VM_TEXT = 4,
 
 	/* Bit flags to store state */
 
@@ -29,6 +32,9 @@ enum vm_type {
 #include "vm/uninit.h"
 #include "vm/anon.h"
 #include "vm/file.h"
+#include "vm/text.h"
+#include "vm/ksm.h"
+#include "vm/zswap.h"
 #ifdef EFILESYS
 #include "filesys/page_cache.h"
 #endif
@@ -48,7 +54,7 @@ struct page {
 	struct frame *frame;   /* Back reference for frame */
 
 	/* Your implementation */
-	struct hash_elem spt_elem;
+	struct ohash_elem spt_elem;  /* Keyed by VA. */
 	bool writable;
 	enum vm_type vm_type;
 
@@ -58,6 +64,7 @@ struct page {
 		struct uninit_page uninit;
 		struct anon_page anon;
 		struct file_page file;
+		struct text_page text;
 #ifdef EFILESYS
 		struct page_cache page_cache;
 #endif
@@ -69,6 +76,34 @@ struct frame {
 	void *kva;
 	struct page *page;
 	struct list_elem list_elem;
+	int pin_cnt;           /* Pins held; not evictable while nonzero. */
+	bool evicting;         /* Off the frame table, being swapped out. */
+	uint64_t *pml4;        /* Page table that maps PAGE. */
+	unsigned checksum;     /* Contents hash at the last merge scan. */
+	bool merged;           /* Embedded in a struct ksm_frame. */
+};
+
+/* One page of read-only program text, mapped into every process
+ * running the same executable.  The frame is never put on the
+ * frame table, so it is never evicted; its owner frees it with
+ * text_frame_free() once no process maps it. */
+struct text_frame {
+	struct frame frame;     /* KVA is NULL until first touched. */
+	bool loading;           /* Being read in by text_claim_page(). */
+	struct file *file;      /* Where the contents come from. */
+	off_t ofs;
+	uint32_t read_bytes;    /* The rest of the page is zeros. */
+};
+
+/* A frame that several anonymous pages with identical contents were
+ * merged onto by the ksm thread.  Every one of them maps it
+ * read-only and gets a private copy on its first write.  It is not
+ * on the frame table. */
+struct ksm_frame {
+	struct frame frame;
+	unsigned checksum;      /* hash_bytes() of the contents. */
+	int ref_cnt;            /* Pages mapping it. */
+	struct list_elem elem;  /* Stable table bucket. */
 };
 
 /* The function table for page operations.
@@ -93,7 +128,7 @@ struct page_operations {
 struct supplemental_page_table {
 
 	// 송원 : 왜... 포인터변수로 선언하면 안될까..??
-	struct hash hash_table;
+	struct ohash pages;    /* struct page, by spt_elem. */
 };
 
 #include "threads/thread.h"
@@ -115,14 +150,18 @@ bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 bool vm_alloc_page_with_initializer (enum vm_type type, void *upage,
 		bool writable, vm_initializer *init, void *aux);
 void vm_dealloc_page (struct page *page);
+void vm_hold_frame (struct page *page);
+void vm_free_frame (struct page *page);
 bool vm_claim_page (void *va);
 enum vm_type page_get_type (struct page *page);
+bool vm_pin_buffer (const void *buffer, size_t size, bool write);
+void vm_unpin_buffer (const void *buffer, size_t size);
+void *vm_steal_page (void);
+void vm_print_stats (void);
 
 /* helper functions for page hash */
-unsigned page_hash (const struct hash_elem *p_, void *aux UNUSED);
-bool page_less (const struct hash_elem *a_, const struct hash_elem *b_, void *aux);
-void page_hash_destructor(struct hash_elem *e, void *aux);
-void page_hash_copy(struct hash_elem *src_elem, void *aux);
-void page_kill(struct hash_elem *elem, void *aux);
+void page_hash_destructor(struct ohash_elem *e);
+void page_hash_copy(struct ohash_elem *src_elem);
+void page_kill(struct ohash_elem *elem);
 
 #endif  /* VM_VM_H */
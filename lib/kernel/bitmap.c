@@ -27,8 +27,25 @@ typedef unsigned long elem_type;
 struct bitmap {
 	size_t bit_cnt;     /* Number of bits. */
 	elem_type *bits;    /* Elements that represent bits. */
+	size_t first_clear; /* No bit below this one is false. */
 };
 
+/* FIRST_CLEAR is updated without a lock: frees may lower it while a
+   scan is working from an older value.  So it is only ever lowered
+   with lower_hint(), and a scan raises it only if it has not
+   changed since the scan read it. */
+
+/* Lowers B's first-clear hint to BIT_IDX if it is above it. */
+static inline void
+lower_hint (struct bitmap *b, size_t bit_idx) {
+	size_t hint = __atomic_load_n (&b->first_clear, __ATOMIC_RELAXED);
+
+	while (bit_idx < hint
+			&& !__atomic_compare_exchange_n (&b->first_clear, &hint, bit_idx,
+				false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		continue;
+}
+
 /* Returns the index of the element that contains the bit
    numbered BIT_IDX. */
 static inline size_t
@@ -63,6 +80,10 @@ last_mask (const struct bitmap *b) {
 	return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
 
+static size_t next_bit (const struct bitmap *, size_t start, bool value);
+static size_t find_run (const struct bitmap *, size_t start, size_t cnt,
+		bool value, size_t *first);
+
 /* Creation and destruction. */
 
 /* Initializes B to be a bitmap of BIT_CNT bits
@@ -74,6 +95,7 @@ bitmap_create (size_t bit_cnt) {
 	struct bitmap *b = malloc (sizeof *b);
 	if (b != NULL) {
 		b->bit_cnt = bit_cnt;
+		b->first_clear = 0;
 		b->bits = malloc (byte_cnt (bit_cnt));
 		if (b->bits != NULL || bit_cnt == 0) {
 			bitmap_set_all (b, false);
@@ -94,6 +116,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED) {
 	ASSERT (block_size >= bitmap_buf_size (bit_cnt));
 
 	b->bit_cnt = bit_cnt;
+	b->first_clear = 0;
 	b->bits = (elem_type *) (b + 1);
 	bitmap_set_all (b, false);
 	return b;
@@ -160,6 +183,7 @@ bitmap_reset (struct bitmap *b, size_t bit_idx) {
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the AND instruction in [IA32-v2a]. */
 	asm ("lock andq %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+	lower_hint (b, bit_idx);
 }
 
 /* Atomically toggles the bit numbered IDX in B;
@@ -174,6 +198,7 @@ bitmap_flip (struct bitmap *b, size_t bit_idx) {
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the XOR instruction in [IA32-v2b]. */
 	asm ("lock xorq %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+	lower_hint (b, bit_idx);
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -194,17 +219,25 @@ bitmap_set_all (struct bitmap *b, bool value) {
 	bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE.  Whole
+   elements in the middle of the range are stored at once. */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
+	size_t i = start, end = start + cnt;
 
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		bitmap_set (b, start + i, value);
+	for (; i < end && i % ELEM_BITS != 0; i++)
+		bitmap_set (b, i, value);
+	for (; i + ELEM_BITS <= end; i += ELEM_BITS)
+		b->bits[elem_idx (i)] = value ? (elem_type) -1 : 0;
+	for (; i < end; i++)
+		bitmap_set (b, i, value);
+
+	if (!value && cnt > 0)
+		lower_hint (b, start);
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -228,16 +261,11 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) {
    exclusive, are set to VALUE, and false otherwise. */
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
-
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
-			return true;
-	return false;
+	return cnt > 0 && next_bit (b, start, value) < start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -275,17 +303,9 @@ bitmap_all (const struct bitmap *b, size_t start, size_t cnt) {
 
 size_t
 bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	ASSERT (b != NULL);
-	ASSERT (start <= b->bit_cnt);
+	size_t first;
 
-	if (cnt <= b->bit_cnt) {
-		size_t last = b->bit_cnt - cnt;
-		size_t i;
-		for (i = start; i <= last; i++)
-			if (!bitmap_contains (b, i, cnt, !value))
-				return i;
-	}
-	return BITMAP_ERROR;
+	return find_run (b, start, cnt, value, &first);
 }
 
 /* Finds the first group of CNT consecutive bits in B at or after
@@ -297,12 +317,82 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
    setting them. */
 size_t
 bitmap_scan_and_flip (struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t idx = bitmap_scan (b, start, cnt, value);
+	size_t hint = __atomic_load_n (&b->first_clear, __ATOMIC_RELAXED);
+	size_t first;
+	size_t idx = find_run (b, start, cnt, value, &first);
+
 	if (idx != BITMAP_ERROR)
 		bitmap_set_multiple (b, idx, cnt, !value);
+
+	/* Everything below FIRST was true, so the next scan for false
+	   bits may start there, or past the run if that is where the
+	   run began.  A bit freed since we read HINT may lie below
+	   that, in which case the hint has moved and is left alone. */
+	if (!value && start <= hint && cnt > 0) {
+		size_t raised = idx == first ? first + cnt : first;
+		if (raised > hint)
+			__atomic_compare_exchange_n (&b->first_clear, &hint, raised,
+					false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+	}
 	return idx;
 }
-
+
+/* Returns the index of the first bit at or after START in B that is
+   set to VALUE, or B's size if there is none.  Looks at a whole
+   element at a time, skipping those with no such bit. */
+static size_t
+next_bit (const struct bitmap *b, size_t start, bool value) {
+	elem_type flip = value ? 0 : (elem_type) -1;
+	size_t idx = elem_idx (start);
+	elem_type word;
+	size_t bit;
+
+	if (start >= b->bit_cnt)
+		return b->bit_cnt;
+
+	/* Bits equal to VALUE become 1s. */
+	word = (b->bits[idx] ^ flip) & ((elem_type) -1 << (start % ELEM_BITS));
+	while (word == 0) {
+		if (++idx >= elem_cnt (b->bit_cnt))
+			return b->bit_cnt;
+		word = b->bits[idx] ^ flip;
+	}
+	bit = idx * ELEM_BITS + __builtin_ctzl (word);
+	return bit < b->bit_cnt ? bit : b->bit_cnt;
+}
+
+/* Finds the first group of CNT consecutive bits in B at or after
+   START that are all set to VALUE, and returns its index, or
+   BITMAP_ERROR.  Sets *FIRST to the first bit at or after START
+   that is VALUE, run or not.  Jumps from each run of VALUE bits to
+   the end of the run rather than retrying one bit further on. */
+static size_t
+find_run (const struct bitmap *b, size_t start, size_t cnt, bool value,
+		size_t *first) {
+	size_t i, end;
+
+	ASSERT (b != NULL);
+	ASSERT (start <= b->bit_cnt);
+
+	if (cnt == 0) {
+		*first = start;
+		return start;
+	}
+	if (!value) {
+		size_t hint = __atomic_load_n (&b->first_clear, __ATOMIC_RELAXED);
+		if (start < hint)
+			start = hint;
+	}
+	*first = next_bit (b, start, value);
+
+	for (i = *first; i < b->bit_cnt && cnt <= b->bit_cnt - i; i = next_bit (b, end, value)) {
+		end = next_bit (b, i, !value);
+		if (end - i >= cnt)
+			return i;
+	}
+	return BITMAP_ERROR;
+}
+
 /* File input and output. */
 
 #ifdef FILESYS
@@ -321,6 +411,7 @@ bitmap_read (struct bitmap *b, struct file *file) {
 		off_t size = byte_cnt (b->bit_cnt);
 		success = file_read_at (file, b->bits, size, 0) == size;
 		b->bits[elem_cnt (b->bit_cnt) - 1] &= last_mask (b);
+		b->first_clear = 0;
 	}
 	return success;
 }
@@ -6,9 +6,41 @@
 #include "threads/init.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 
 static void vprintf_helper (char, void *);
 static void putchar_have_lock (uint8_t c);
+static void console_kick (void);
+static bool drain_batch (void);
+static void drain_sync (void);
+static void console_drain (void *);
+
+/* Console output ring.
+   Writers append bytes at RING_HEAD under the console lock (or,
+   from interrupt context, with interrupts off, which on our one
+   CPU excludes every other writer), and the drain thread takes
+   them from RING_TAIL in batches and pushes them out to the
+   serial port and vga display.  Both indexes run freely and are
+   reduced modulo RING_SIZE only when the ring is indexed, so
+   HEAD - TAIL is always the number of bytes waiting. */
+#define RING_SIZE 16384                 /* Power of 2. */
+#define DRAIN_BATCH 256                 /* Bytes drained at a time. */
+static char ring[RING_SIZE];
+static volatile size_t ring_head;
+static volatile size_t ring_tail;
+
+/* Drain thread.  It sleeps on DRAIN_SEMA until a writer kicks
+   it, and holds DRAIN_LOCK while it writes out a batch so that
+   console_flush() can wait for it to finish. */
+static struct thread *drain_thread;
+static struct semaphore drain_sema;
+static struct lock drain_lock;
+static bool drain_kicked;
+
+/* A writer that finds the ring full waits on SPACE_SEMA until
+   the drain thread has emptied half of it. */
+static struct semaphore space_sema;
+static bool space_wanted;
 
 /* The console lock.
    Both the vga and serial layers do their own locking, so it's
@@ -59,6 +91,11 @@ static int console_lock_depth;
 /* Number of characters written to console. */
 static int64_t write_cnt;
 
+/* Number of batches drained, and number of times a writer had
+   to wait for room in the ring. */
+static int64_t batch_cnt;
+static int64_t stall_cnt;
+
 /* Enable console locking. */
 void
 console_init (void) {
@@ -66,6 +103,37 @@ console_init (void) {
 	use_console_lock = true;
 }
 
+/* Starts the drain thread.  Until this is called, output is
+   written out synchronously as it is produced. */
+void
+console_start (void) {
+	tid_t tid;
+
+	sema_init (&drain_sema, 0);
+	sema_init (&space_sema, 0);
+	lock_init (&drain_lock);
+
+	/* One step below the default priority, so that the drain
+	   thread runs when writers block or the ring fills up
+	   rather than after every write, and gets whole lines to
+	   work with. */
+	tid = thread_create ("console", PRI_DEFAULT - 1, console_drain, NULL);
+	ASSERT (tid != TID_ERROR);
+}
+
+/* Writes out everything waiting in the console ring and then
+   in the serial transmit queue. */
+void
+console_flush (void) {
+	if (drain_thread != NULL && use_console_lock && !intr_context ()) {
+		lock_acquire (&drain_lock);
+		drain_sync ();
+		lock_release (&drain_lock);
+	} else
+		drain_sync ();
+	serial_flush ();
+}
+
 /* Notifies the console that a kernel panic is underway,
    which warns it to avoid trying to take the console lock from
    now on. */
@@ -77,7 +145,8 @@ console_panic (void) {
 /* Prints console statistics. */
 void
 console_print_stats (void) {
-	printf ("Console: %lld characters output\n", write_cnt);
+	printf ("Console: %lld characters output, %lld batches drained, "
+			"%lld writer stalls\n", write_cnt, batch_cnt, stall_cnt);
 }
 
 /* Acquires the console lock. */
@@ -91,9 +160,15 @@ acquire_console (void) {
 	}
 }
 
-/* Releases the console lock. */
+/* Releases the console lock, first making sure that what was
+   written under it will reach the console. */
 static void
 release_console (void) {
+	if (drain_thread == NULL || !use_console_lock)
+		drain_sync ();
+	else if (ring_head != ring_tail)
+		console_kick ();
+
 	if (!intr_context () && use_console_lock) {
 		if (console_lock_depth > 0)
 			console_lock_depth--;
@@ -165,13 +240,108 @@ vprintf_helper (char c, void *char_cnt_) {
 	putchar_have_lock (c);
 }
 
-/* Writes C to the vga display and serial port.
-   The caller has already acquired the console lock if
-   appropriate. */
+/* Appends C to the console ring, making room for it first if
+   the ring is full.  The caller has already acquired the console
+   lock if appropriate. */
 static void
 putchar_have_lock (uint8_t c) {
+	enum intr_level old_level;
+
 	ASSERT (console_locked_by_current_thread ());
 	write_cnt++;
-	serial_putc (c);
-	vga_putc (c);
+
+	old_level = intr_disable ();
+	while (ring_head - ring_tail >= RING_SIZE) {
+		if (drain_thread != NULL && use_console_lock
+				&& !intr_context () && old_level == INTR_ON) {
+			/* Wait for the drain thread.  We hold the console lock,
+			   but the drain thread never takes it. */
+			stall_cnt++;
+			space_wanted = true;
+			console_kick ();
+			sema_down (&space_sema);
+		} else {
+			/* We can't sleep here, so write out a batch
+			   ourselves. */
+			intr_set_level (old_level);
+			drain_batch ();
+			old_level = intr_disable ();
+		}
+	}
+	ring[ring_head % RING_SIZE] = c;
+	barrier ();
+	ring_head++;
+	intr_set_level (old_level);
+}
+
+/* Wakes up the drain thread, unless it has already been woken
+   and has not yet started draining. */
+static void
+console_kick (void) {
+	enum intr_level old_level = intr_disable ();
+	if (!drain_kicked) {
+		drain_kicked = true;
+		sema_up (&drain_sema);
+	}
+	intr_set_level (old_level);
+}
+
+/* Takes up to DRAIN_BATCH bytes off the console ring and writes
+   them to the serial port and vga display.  Returns false if the
+   ring was empty. */
+static bool
+drain_batch (void) {
+	char batch[DRAIN_BATCH];
+	enum intr_level old_level;
+	bool wake = false;
+	size_t n, i;
+
+	/* Claim the batch with interrupts off, so that a writer in
+	   an interrupt handler that drains synchronously cannot
+	   write out the same bytes. */
+	old_level = intr_disable ();
+	n = ring_head - ring_tail;
+	if (n > DRAIN_BATCH)
+		n = DRAIN_BATCH;
+	for (i = 0; i < n; i++)
+		batch[i] = ring[(ring_tail + i) % RING_SIZE];
+	ring_tail += n;
+	if (n > 0)
+		batch_cnt++;
+	if (space_wanted && ring_head - ring_tail <= RING_SIZE / 2) {
+		space_wanted = false;
+		wake = true;
+	}
+	intr_set_level (old_level);
+
+	for (i = 0; i < n; i++) {
+		serial_putc (batch[i]);
+		vga_putc (batch[i]);
+	}
+
+	/* Let a waiting writer go only once this batch is out, so
+	   that its output cannot overtake ours. */
+	if (wake)
+		sema_up (&space_sema);
+	return n > 0;
+}
+
+/* Empties the console ring in the calling thread. */
+static void
+drain_sync (void) {
+	while (drain_batch ())
+		continue;
+}
+
+/* Drain thread function. */
+static void
+console_drain (void *aux UNUSED) {
+	drain_thread = thread_current ();
+	for (;;) {
+		sema_down (&drain_sema);
+		lock_acquire (&drain_lock);
+		drain_kicked = false;
+		drain_sync ();
+		lock_release (&drain_lock);
+	}
 }
@@ -7,7 +7,6 @@
 #include <string.h>
 #include "threads/init.h"
 #include "threads/interrupt.h"
-#include "devices/serial.h"
 
 /* Halts the OS, printing the source file name, line number, and
    function name, plus a user-specific message. */
@@ -37,7 +36,7 @@ debug_panic (const char *file, int line, const char *function,
 		/* Don't print anything: that's probably why we recursed. */
 	}
 
-	serial_flush ();
+	console_flush ();
 	if (power_off_when_done)
 		power_off ();
 	for (;;);
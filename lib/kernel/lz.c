@@ -0,0 +1,171 @@
+#include "lz.h"
+#include <debug.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* Largest match offset a sequence can encode. */
+#define LZ_MAX_OFFSET 65535
+
+/* Reads 4 bytes at P, which need not be aligned. */
+static uint32_t
+read32 (const uint8_t *p) {
+	uint32_t v;
+	memcpy (&v, p, sizeof v);
+	return v;
+}
+
+/* Returns the match table slot for the 4 bytes V. */
+static unsigned
+hash4 (uint32_t v) {
+	return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* Appends the continuation bytes of a length nibble that overflowed
+ * by LEN to OP, not going past OEND.  Returns the new end of the
+ * output, or NULL if it does not fit. */
+static uint8_t *
+put_length (uint8_t *op, uint8_t *oend, size_t len) {
+	for (; len >= 255; len -= 255) {
+		if (op >= oend)
+			return NULL;
+		*op++ = 255;
+	}
+	if (op >= oend)
+		return NULL;
+	*op++ = len;
+	return op;
+}
+
+/* Appends a sequence of the LIT_LEN bytes at LIT followed by a match
+ * of MATCH_LEN bytes OFFSET back, or by nothing if MATCH_LEN is 0.
+ * Returns the new end of the output, or NULL if it would pass
+ * OEND. */
+static uint8_t *
+put_sequence (uint8_t *op, uint8_t *oend, const uint8_t *lit,
+		size_t lit_len, size_t offset, size_t match_len) {
+	size_t ml = match_len ? match_len - LZ_MIN_MATCH : 0;
+	uint8_t *token;
+
+	if (op >= oend)
+		return NULL;
+	token = op++;
+	*token = (lit_len < 15 ? lit_len : 15) << 4 | (ml < 15 ? ml : 15);
+	if (lit_len >= 15 && (op = put_length (op, oend, lit_len - 15)) == NULL)
+		return NULL;
+	if ((size_t) (oend - op) < lit_len)
+		return NULL;
+	memcpy (op, lit, lit_len);
+	op += lit_len;
+
+	if (match_len) {
+		if (oend - op < 2)
+			return NULL;
+		*op++ = offset & 0xff;
+		*op++ = offset >> 8;
+		if (ml >= 15 && (op = put_length (op, oend, ml - 15)) == NULL)
+			return NULL;
+	}
+	return op;
+}
+
+/* Compresses the SRC_LEN bytes at SRC into DST, which has room for
+ * DST_CAP bytes, using the LZ_WORK_SIZE bytes at WORK as scratch.
+ * Returns the compressed size, or 0 if it would exceed DST_CAP. */
+size_t
+lz_compress (const void *src_, size_t src_len,
+		void *dst_, size_t dst_cap, void *work) {
+	const uint8_t *src = src_;
+	const uint8_t *end = src + src_len;
+	const uint8_t *ip = src, *anchor = src;
+	uint8_t *dst = dst_, *op = dst, *oend = dst + dst_cap;
+	uint16_t *table = work;
+
+	ASSERT (src_len <= LZ_MAX_OFFSET + 1);
+
+	/* Stale or unset slots are harmless: every candidate is
+	 * compared against the input before it is used. */
+	memset (table, 0, LZ_WORK_SIZE);
+
+	while (src_len >= LZ_MIN_MATCH && ip <= end - LZ_MIN_MATCH) {
+		uint32_t seq = read32 (ip);
+		unsigned h = hash4 (seq);
+		const uint8_t *ref = src + table[h];
+
+		table[h] = ip - src;
+		if (ref < ip && read32 (ref) == seq) {
+			const uint8_t *m = ip + LZ_MIN_MATCH;
+			const uint8_t *r = ref + LZ_MIN_MATCH;
+
+			while (m < end && *m == *r)
+				m++, r++;
+			op = put_sequence (op, oend, anchor, ip - anchor, ip - ref, m - ip);
+			if (op == NULL)
+				return 0;
+			ip = anchor = m;
+		} else
+			ip++;
+	}
+
+	op = put_sequence (op, oend, anchor, end - anchor, 0, 0);
+	return op != NULL ? (size_t) (op - dst) : 0;
+}
+
+/* Reads the continuation bytes of a length nibble from *IP, not
+ * going past IEND, and adds them to *LEN.  Returns false if the
+ * input ends first. */
+static bool
+get_length (const uint8_t **ip, const uint8_t *iend, size_t *len) {
+	uint8_t b;
+
+	do {
+		if (*ip >= iend)
+			return false;
+		b = *(*ip)++;
+		*len += b;
+	} while (b == 255);
+	return true;
+}
+
+/* Decompresses the SRC_LEN bytes at SRC into DST, which has room
+ * for DST_CAP bytes.  Returns the decompressed size, or 0 if SRC
+ * is malformed or decompresses to more than DST_CAP bytes. */
+size_t
+lz_decompress (const void *src_, size_t src_len,
+		void *dst_, size_t dst_cap) {
+	const uint8_t *ip = src_, *iend = ip + src_len;
+	uint8_t *dst = dst_, *op = dst, *oend = dst + dst_cap;
+
+	while (ip < iend) {
+		unsigned token = *ip++;
+		size_t lit = token >> 4;
+		size_t ml = token & 15;
+		size_t offset;
+		const uint8_t *r;
+
+		if (lit == 15 && !get_length (&ip, iend, &lit))
+			return 0;
+		if (lit > (size_t) (iend - ip) || lit > (size_t) (oend - op))
+			return 0;
+		memcpy (op, ip, lit);
+		op += lit;
+		ip += lit;
+		if (ip == iend)
+			break;
+
+		if (iend - ip < 2)
+			return 0;
+		offset = ip[0] | ip[1] << 8;
+		ip += 2;
+		if (ml == 15 && !get_length (&ip, iend, &ml))
+			return 0;
+		ml += LZ_MIN_MATCH;
+		if (offset == 0 || offset > (size_t) (op - dst)
+				|| ml > (size_t) (oend - op))
+			return 0;
+
+		/* Byte by byte: the match may overlap its own output. */
+		for (r = op - offset; ml > 0; ml--)
+			*op++ = *r++;
+	}
+	return op - dst;
+}
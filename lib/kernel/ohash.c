@@ -0,0 +1,276 @@
+/* Open-addressing hash table.
+
+   See ohash.h for basic information. */
+
+#include "ohash.h"
+#include "../debug.h"
+#include "threads/malloc.h"
+
+#define MIN_BITS 4              /* Smallest slot array: 16 slots. */
+#define DRAIN_STEP 4            /* Elements moved per insert/delete. */
+
+static size_t home_slot (const struct ohash_table *, uint64_t key);
+static struct ohash_slot *table_find (struct ohash_table *, uint64_t key);
+static void table_put (struct ohash_table *, uint64_t key,
+		struct ohash_elem *);
+static void table_remove (struct ohash_table *, struct ohash_slot *);
+static void table_clear (struct ohash_table *, ohash_action_func *);
+static void drain (struct ohash *, size_t cnt);
+static void grow (struct ohash *);
+
+/* Initializes open hash table H.  No memory is allocated until the
+   first insertion, so this always succeeds. */
+bool
+ohash_init (struct ohash *h) {
+	h->cur = (struct ohash_table) { .slots = NULL };
+	h->old = (struct ohash_table) { .slots = NULL };
+	h->drain_pos = 0;
+	return true;
+}
+
+/* Removes all the elements from H, calling DESTRUCTOR, if it is
+   non-null, on each.  Modifying H from DESTRUCTOR yields undefined
+   behavior, as with hash_clear(). */
+void
+ohash_clear (struct ohash *h, ohash_action_func *destructor) {
+	table_clear (&h->cur, destructor);
+	table_clear (&h->old, destructor);
+	free (h->old.slots);
+	h->old = (struct ohash_table) { .slots = NULL };
+	h->drain_pos = 0;
+}
+
+/* Destroys H, calling DESTRUCTOR, if it is non-null, on each
+   element first.  The same caveats as for ohash_clear() apply. */
+void
+ohash_destroy (struct ohash *h, ohash_action_func *destructor) {
+	ohash_clear (h, destructor);
+	free (h->cur.slots);
+	h->cur = (struct ohash_table) { .slots = NULL };
+}
+
+/* Inserts NEW into H and returns OHASH_INSERTED, if no element
+   with the same key is already in the table.  Otherwise leaves the
+   table unchanged and returns OHASH_DUPLICATE, or OHASH_NO_MEMORY
+   if the table is full and memory to grow it cannot be had. */
+enum ohash_insert_result
+ohash_insert (struct ohash *h, struct ohash_elem *new) {
+	if (ohash_find (h, new->key) != NULL)
+		return OHASH_DUPLICATE;
+
+	drain (h, DRAIN_STEP);
+	if (h->cur.slots == NULL
+			|| (ohash_size (h) + 1) * 8 > (h->cur.mask + 1) * 7)
+		grow (h);
+	/* Keep one slot empty, so that every probe ends. */
+	if (h->cur.slots == NULL || h->cur.elem_cnt == h->cur.mask)
+		return OHASH_NO_MEMORY;
+	table_put (&h->cur, new->key, new);
+	return OHASH_INSERTED;
+}
+
+/* Returns the element in H with key KEY, or a null pointer if
+   there is none. */
+struct ohash_elem *
+ohash_find (struct ohash *h, uint64_t key) {
+	struct ohash_slot *s = table_find (&h->cur, key);
+
+	if (s == NULL)
+		s = table_find (&h->old, key);
+	return s != NULL ? s->elem : NULL;
+}
+
+/* Finds, removes, and returns the element in H with the same key as
+   E.  Returns a null pointer if there is none. */
+struct ohash_elem *
+ohash_delete (struct ohash *h, struct ohash_elem *e) {
+	struct ohash_table *t = &h->cur;
+	struct ohash_slot *s = table_find (t, e->key);
+	struct ohash_elem *found;
+
+	if (s == NULL) {
+		t = &h->old;
+		s = table_find (t, e->key);
+		if (s == NULL)
+			return NULL;
+	}
+	found = s->elem;
+	table_remove (t, s);
+	drain (h, DRAIN_STEP);
+	return found;
+}
+
+/* Calls ACTION for each element in H, in no particular order.
+   ACTION must not insert or delete elements of H. */
+void
+ohash_apply (struct ohash *h, ohash_action_func *action) {
+	struct ohash_table *tables[] = { &h->cur, &h->old };
+	size_t i, j;
+
+	ASSERT (action != NULL);
+
+	for (i = 0; i < 2; i++)
+		if (tables[i]->slots != NULL)
+			for (j = 0; j <= tables[i]->mask; j++)
+				if (tables[i]->slots[j].elem != NULL)
+					action (tables[i]->slots[j].elem);
+}
+
+/* Returns the number of elements in H. */
+size_t
+ohash_size (struct ohash *h) {
+	return h->cur.elem_cnt + h->old.elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+ohash_empty (struct ohash *h) {
+	return ohash_size (h) == 0;
+}
+
+/* Returns the slot of T where KEY would be found with no
+   collisions.  Fibonacci hashing: the top bits of the product mix
+   in every bit of the key, so page-aligned keys spread well. */
+static size_t
+home_slot (const struct ohash_table *t, uint64_t key) {
+	return (key * 0x9e3779b97f4a7c15ULL) >> (64 - t->bits);
+}
+
+/* Returns the slot of T holding KEY, or a null pointer. */
+static struct ohash_slot *
+table_find (struct ohash_table *t, uint64_t key) {
+	size_t pos, dist;
+
+	if (t->slots == NULL)
+		return NULL;
+
+	for (pos = home_slot (t, key), dist = 0; ; pos = (pos + 1) & t->mask, dist++) {
+		struct ohash_slot *s = &t->slots[pos];
+
+		if (s->elem == NULL)
+			return NULL;
+		if (s->key == key)
+			return s;
+		/* KEY would have displaced this element. */
+		if (((pos - home_slot (t, s->key)) & t->mask) < dist)
+			return NULL;
+	}
+}
+
+/* Puts ELEM, whose key is KEY, into T, which must have a free
+   slot. */
+static void
+table_put (struct ohash_table *t, uint64_t key, struct ohash_elem *elem) {
+	size_t pos, dist;
+
+	for (pos = home_slot (t, key), dist = 0; ; pos = (pos + 1) & t->mask, dist++) {
+		struct ohash_slot *s = &t->slots[pos];
+		size_t s_dist;
+
+		if (s->elem == NULL) {
+			s->key = key;
+			s->elem = elem;
+			t->elem_cnt++;
+			return;
+		}
+
+		/* Take the slot from an element nearer its home, and go on
+		   to place that one instead. */
+		s_dist = (pos - home_slot (t, s->key)) & t->mask;
+		if (s_dist < dist) {
+			struct ohash_slot displaced = *s;
+			s->key = key;
+			s->elem = elem;
+			key = displaced.key;
+			elem = displaced.elem;
+			dist = s_dist;
+		}
+	}
+}
+
+/* Empties slot S of T, shifting back the elements after it that
+   are not in their home slot. */
+static void
+table_remove (struct ohash_table *t, struct ohash_slot *s) {
+	size_t pos = s - t->slots;
+
+	for (;;) {
+		size_t next = (pos + 1) & t->mask;
+		struct ohash_slot *n = &t->slots[next];
+
+		if (n->elem == NULL || home_slot (t, n->key) == next)
+			break;
+		t->slots[pos] = *n;
+		pos = next;
+	}
+	t->slots[pos].elem = NULL;
+	t->elem_cnt--;
+}
+
+/* Empties T, calling DESTRUCTOR on each element if non-null. */
+static void
+table_clear (struct ohash_table *t, ohash_action_func *destructor) {
+	size_t i;
+
+	if (t->slots == NULL)
+		return;
+	for (i = 0; i <= t->mask; i++) {
+		struct ohash_elem *e = t->slots[i].elem;
+
+		t->slots[i].elem = NULL;
+		if (e != NULL && destructor != NULL)
+			destructor (e);
+	}
+	t->elem_cnt = 0;
+}
+
+/* Moves up to CNT elements of H's old slot array into the current
+   one, and frees the old array once it is empty.  Removing from the
+   old array shifts its later elements back, so a slot is revisited
+   until it comes up empty. */
+static void
+drain (struct ohash *h, size_t cnt) {
+	struct ohash_table *old = &h->old;
+
+	while (old->elem_cnt > 0 && cnt > 0) {
+		struct ohash_slot *s = &old->slots[h->drain_pos];
+
+		if (s->elem != NULL) {
+			table_put (&h->cur, s->key, s->elem);
+			table_remove (old, s);
+			cnt--;
+		} else
+			h->drain_pos = (h->drain_pos + 1) & old->mask;
+	}
+
+	if (old->slots != NULL && old->elem_cnt == 0) {
+		free (old->slots);
+		*old = (struct ohash_table) { .slots = NULL };
+		h->drain_pos = 0;
+	}
+}
+
+/* Makes a slot array twice the size of H's current one the new
+   current array, and starts draining the previous one into it.
+   If memory is short, leaves H as it was: the table keeps working
+   at a higher load until it is completely full. */
+static void
+grow (struct ohash *h) {
+	struct ohash_table new;
+
+	/* Finish an earlier resize first.  This only happens if half
+	   the elements were inserted since it began. */
+	drain (h, SIZE_MAX);
+
+	new.bits = h->cur.slots != NULL ? h->cur.bits + 1 : MIN_BITS;
+	new.mask = ((size_t) 1 << new.bits) - 1;
+	new.elem_cnt = 0;
+	new.slots = calloc (new.mask + 1, sizeof *new.slots);
+	if (new.slots == NULL)
+		return;
+
+	h->old = h->cur;
+	h->cur = new;
+	h->drain_pos = 0;
+	drain (h, 0);
+}
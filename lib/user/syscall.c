@@ -54,7 +54,7 @@ static __inline int64_t syscall (uint64_t num_, uint64_t a1_, uint64_t a2_,
 			((uint64_t) ARG2), 0, 0, 0))
 
 #define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3) ( \
-		syscall(((uint64_t *) NUMBER), \
+		syscall(((uint64_t) NUMBER), \
 			((uint64_t) ARG0), \
 			((uint64_t) ARG1), \
 			((uint64_t) ARG2), \
@@ -85,11 +85,32 @@ fork (const char *thread_name){
 	return (pid_t) syscall1 (SYS_FORK, thread_name);
 }
 
+/* The child runs on our stack until it calls exec() or exit(), and
+   its next call would overwrite the return address we were called
+   with.  Keep that address in a register instead, which the kernel
+   saves separately for parent and child. */
+__attribute__((naked)) pid_t
+vfork (const char *thread_name UNUSED) {
+	__asm __volatile(
+			"pop %%rdx\n"
+			"mov %0, %%rax\n"
+			"syscall\n"
+			"push %%rdx\n"
+			"ret\n"
+			: : "i" (SYS_VFORK));
+}
+
 int
 exec (const char *file) {
 	return (pid_t) syscall1 (SYS_EXEC, file);
 }
 
+pid_t
+spawn (const char *file, char *const argv[],
+		const struct spawn_fd *fds, int fd_cnt) {
+	return (pid_t) syscall4 (SYS_SPAWN, file, argv, fds, fd_cnt);
+}
+
 int
 wait (pid_t pid) {
 	return syscall1 (SYS_WAIT, pid);
@@ -145,6 +166,36 @@ dup2 (int oldfd, int newfd){
 	return syscall2 (SYS_DUP2, oldfd, newfd);
 }
 
+int
+readv (int fd, const struct iovec *iov, int iovcnt) {
+	return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt) {
+	return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int
+pread (int fd, void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int
+ring_setup (struct ring_sq *sq, struct ring_cq *cq) {
+	return syscall2 (SYS_RING_SETUP, sq, cq);
+}
+
+int
+ring_enter (unsigned to_submit) {
+	return syscall1 (SYS_RING_ENTER, to_submit);
+}
+
 void *
 mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 	return (void *) syscall5 (SYS_MMAP, addr, length, writable, fd, offset);
@@ -0,0 +1,66 @@
+/* Writes out a large file, then reads it back sequentially
+   several times, first in sector-aligned blocks and then in
+   odd-sized blocks that split sectors, and reports the read
+   bandwidth of each in bytes per kilocycle. */
+
+#include <random.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define TEST_SIZE 65536
+#define PASSES 8
+
+static char buf[TEST_SIZE];
+static char rbuf[TEST_SIZE];
+
+static void
+read_back (const char *file_name, size_t block_size)
+{
+  unsigned long long start, cycles;
+  int fd, pass;
+
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  msg ("read \"%s\" %d times in %zu-byte blocks",
+       file_name, PASSES, block_size);
+  start = rdtsc ();
+  for (pass = 0; pass < PASSES; pass++)
+    {
+      size_t ofs = 0;
+
+      seek (fd, 0);
+      while (ofs < TEST_SIZE)
+        {
+          size_t size = block_size;
+          if (size > TEST_SIZE - ofs)
+            size = TEST_SIZE - ofs;
+          if (read (fd, rbuf + ofs, size) != (int) size)
+            fail ("read %zu bytes at offset %zu in \"%s\" failed",
+                  size, ofs, file_name);
+          ofs += size;
+        }
+    }
+  cycles = rdtsc () - start;
+  msg ("%zu-byte blocks: %llu bytes per kilocycle", block_size,
+       (unsigned long long) TEST_SIZE * PASSES * 1000 / (cycles + 1));
+  compare_bytes (rbuf, buf, TEST_SIZE, 0, file_name);
+  msg ("close \"%s\"", file_name);
+  close (fd);
+}
+
+void
+test_main (void)
+{
+  const char *file_name = "bandwidth";
+  int fd;
+
+  random_bytes (buf, sizeof buf);
+  CHECK (create (file_name, TEST_SIZE), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  CHECK (write (fd, buf, TEST_SIZE) == TEST_SIZE, "write \"%s\"", file_name);
+  close (fd);
+
+  read_back (file_name, 4096);
+  read_back (file_name, 513);
+}
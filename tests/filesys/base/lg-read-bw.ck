@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^\(lg-read-bw\) \d+-byte blocks: \d+ bytes per kilocycle$/,
+		@output);
+compare_output ("run", IGNORE_EXIT_CODES => 1, \@output, [<<'EOF']);
+(lg-read-bw) begin
+(lg-read-bw) create "bandwidth"
+(lg-read-bw) open "bandwidth"
+(lg-read-bw) write "bandwidth"
+(lg-read-bw) open "bandwidth"
+(lg-read-bw) read "bandwidth" 8 times in 4096-byte blocks
+(lg-read-bw) close "bandwidth"
+(lg-read-bw) open "bandwidth"
+(lg-read-bw) read "bandwidth" 8 times in 513-byte blocks
+(lg-read-bw) close "bandwidth"
+(lg-read-bw) end
+EOF
+pass;
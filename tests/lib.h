@@ -47,4 +47,15 @@ void check_file (const char *file_name, const void *buf, size_t filesize);
 void compare_bytes (const void *read_data, const void *expected_data,
                     size_t size, size_t ofs, const char *file_name);
 
+/* Returns the processor's time-stamp counter.  Benchmarks use it
+   to report elapsed cycles, which user programs have no other
+   way to measure. */
+static inline unsigned long long
+rdtsc (void)
+{
+  unsigned lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((unsigned long long) hi << 32) | lo;
+}
+
 #endif /* test/lib.h */
@@ -0,0 +1,95 @@
+/* Measures allocation from a large, fragmented bitmap, the way
+   palloc, the free map and swap use it.  Runs of 1 to MAX_RUN bits
+   are allocated until the bitmap is three quarters full, then
+   random runs are freed and allocated again.  Each allocation is
+   timed with bitmap_scan_and_flip() and, for comparison, with a
+   scan that tests one bit at a time.
+
+   Rates vary from run to run and are ignored by the checker. */
+
+#include <bitmap.h>
+#include <random.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "intrinsic.h"
+
+#define BIT_CNT 65536           /* Bits in the bitmap. */
+#define MAX_RUN 16              /* Longest run allocated. */
+#define RUN_CNT (BIT_CNT / 4 * 3 / ((MAX_RUN + 1) / 2))
+#define CHURN 4000              /* Free/allocate pairs timed. */
+
+/* An allocated run. */
+struct run 
+  {
+    size_t start;
+    size_t cnt;
+  };
+
+/* Finds CNT false bits in B one bit at a time, as bitmap_scan()
+   used to. */
+static size_t
+slow_scan (const struct bitmap *b, size_t cnt) 
+{
+  size_t i, j;
+
+  for (i = 0; i + cnt <= bitmap_size (b); i++) 
+    {
+      for (j = 0; j < cnt; j++)
+        if (bitmap_test (b, i + j))
+          break;
+      if (j == cnt)
+        return i;
+    }
+  return BITMAP_ERROR;
+}
+
+void
+test_bitmap_bench (void) 
+{
+  struct bitmap *b = bitmap_create (BIT_CNT);
+  struct run *runs = malloc (sizeof *runs * RUN_CNT);
+  uint64_t fast_cycles = 0, slow_cycles = 0, start;
+  size_t run_cnt, i;
+
+  if (b == NULL || runs == NULL)
+    fail ("out of memory");
+  random_init (0);
+
+  for (run_cnt = 0; run_cnt < RUN_CNT; run_cnt++) 
+    {
+      struct run *r = &runs[run_cnt];
+      r->cnt = random_ulong () % MAX_RUN + 1;
+      r->start = bitmap_scan_and_flip (b, 0, r->cnt, false);
+      if (r->start == BITMAP_ERROR)
+        fail ("bitmap filled up at run %zu", run_cnt);
+    }
+
+  for (i = 0; i < CHURN; i++) 
+    {
+      struct run *r = &runs[random_ulong () % run_cnt];
+      size_t slow;
+
+      bitmap_set_multiple (b, r->start, r->cnt, false);
+      r->cnt = random_ulong () % MAX_RUN + 1;
+
+      start = rdtsc ();
+      slow = slow_scan (b, r->cnt);
+      slow_cycles += rdtsc () - start;
+
+      start = rdtsc ();
+      r->start = bitmap_scan_and_flip (b, 0, r->cnt, false);
+      fast_cycles += rdtsc () - start;
+
+      if (r->start != slow)
+        fail ("bitmap_scan_and_flip found %zu, expected %zu", r->start, slow);
+    }
+
+  msg ("bit scan: %llu cycles per allocation", slow_cycles / CHURN);
+  msg ("word scan: %llu cycles per allocation", fast_cycles / CHURN);
+  msg ("%d allocations checked", CHURN);
+
+  free (runs);
+  bitmap_destroy (b);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^\(bitmap-bench\) [a-z ]+: \d+ cycles per allocation$/,
+		@output);
+compare_output ("run", \@output, [<<'EOF']);
+(bitmap-bench) begin
+(bitmap-bench) 4000 allocations checked
+(bitmap-bench) end
+EOF
+pass;
@@ -0,0 +1,69 @@
+/* Measures the cost of a context switch.  Two threads of equal
+   priority pass control back and forth through a pair of
+   semaphores, so that every sema_up hands the CPU to the other
+   thread.  Only kernel threads exist at this level, so the switch
+   is between two threads that share the kernel address space, the
+   case in which the page table need not be reloaded.
+
+   Cycle counts vary from run to run and are ignored by the
+   checker. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define ROUNDS 10000            /* Round trips to time. */
+
+struct pingpong
+  {
+    struct semaphore ping;      /* Upped by the main thread. */
+    struct semaphore pong;      /* Upped by the partner. */
+    int rounds;                 /* Round trips seen by the partner. */
+  };
+
+static thread_func partner_thread;
+
+void
+test_ctxsw_bench (void) 
+{
+  struct pingpong p;
+  uint64_t start;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&p.ping, 0);
+  sema_init (&p.pong, 0);
+  p.rounds = 0;
+  thread_create ("partner", thread_get_priority (), partner_thread, &p);
+
+  start = rdtsc ();
+  for (i = 0; i < ROUNDS; i++) 
+    {
+      sema_up (&p.ping);
+      sema_down (&p.pong);
+    }
+  msg ("%llu cycles per switch", (rdtsc () - start) / (2 * ROUNDS));
+
+  if (p.rounds != ROUNDS)
+    fail ("partner saw %d rounds, expected %d", p.rounds, ROUNDS);
+  msg ("%d round trips completed", ROUNDS);
+}
+
+static void
+partner_thread (void *p_) 
+{
+  struct pingpong *p = p_;
+  int i;
+
+  for (i = 0; i < ROUNDS; i++) 
+    {
+      sema_down (&p->ping);
+      p->rounds++;
+      sema_up (&p->pong);
+    }
+}
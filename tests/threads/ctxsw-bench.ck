@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^\(ctxsw-bench\) \d+ cycles per switch$/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(ctxsw-bench) begin
+(ctxsw-bench) 10000 round trips completed
+(ctxsw-bench) end
+EOF
+pass;
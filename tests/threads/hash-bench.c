@@ -0,0 +1,103 @@
+/* Compares lookup latency of the chained hash table (hash.h) and
+   the open-addressing one (ohash.h) holding as many pages as a
+   large process's supplemental page table.  Both tables are keyed
+   by page address and probed in a scattered order, as page faults
+   would.
+
+   Rates vary from run to run and are ignored by the checker. */
+
+#include <stdio.h>
+#include <hash.h>
+#include <ohash.h>
+#include <round.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+#define PAGE_CNT 32768          /* Elements in each table; a power of 2. */
+#define ROUNDS 4                /* Lookups of each element. */
+#define STRIDE 7919             /* Odd, so it visits every element. */
+
+/* Stands in for struct page. */
+struct fake_page {
+  uint64_t va;
+  struct hash_elem hash_elem;
+  struct ohash_elem ohash_elem;
+};
+
+static uint64_t
+fake_hash (const struct hash_elem *e, void *aux UNUSED) 
+{
+  const struct fake_page *p = hash_entry (e, struct fake_page, hash_elem);
+  return hash_bytes (&p->va, sizeof p->va);
+}
+
+static bool
+fake_less (const struct hash_elem *a_, const struct hash_elem *b_,
+           void *aux UNUSED) 
+{
+  const struct fake_page *a = hash_entry (a_, struct fake_page, hash_elem);
+  const struct fake_page *b = hash_entry (b_, struct fake_page, hash_elem);
+  return a->va < b->va;
+}
+
+void
+test_hash_bench (void) 
+{
+  size_t pg_cnt = DIV_ROUND_UP (PAGE_CNT * sizeof (struct fake_page), PGSIZE);
+  struct fake_page *pages, key;
+  struct hash hash;
+  struct ohash ohash;
+  uint64_t start, cycles;
+  size_t i, j;
+
+  pages = palloc_get_multiple (PAL_ASSERT, pg_cnt);
+  hash_init (&hash, fake_hash, fake_less, NULL);
+  ohash_init (&ohash);
+  for (i = 0; i < PAGE_CNT; i++) 
+    {
+      pages[i].va = 0x400000 + i * PGSIZE;
+      pages[i].ohash_elem.key = pages[i].va;
+      hash_insert (&hash, &pages[i].hash_elem);
+      if (ohash_insert (&ohash, &pages[i].ohash_elem) != OHASH_INSERTED)
+        fail ("ohash_insert failed on page %zu", i);
+    }
+
+  start = rdtsc ();
+  for (i = 0, j = 0; i < ROUNDS * PAGE_CNT; i++, j = (j + STRIDE) % PAGE_CNT) 
+    {
+      key.va = pages[j].va;
+      if (hash_find (&hash, &key.hash_elem) != &pages[j].hash_elem)
+        fail ("hash_find lost page %zu", j);
+    }
+  cycles = rdtsc () - start;
+  msg ("hash: %llu cycles per lookup", cycles / (ROUNDS * PAGE_CNT));
+
+  start = rdtsc ();
+  for (i = 0, j = 0; i < ROUNDS * PAGE_CNT; i++, j = (j + STRIDE) % PAGE_CNT) 
+    if (ohash_find (&ohash, pages[j].va) != &pages[j].ohash_elem)
+      fail ("ohash_find lost page %zu", j);
+  cycles = rdtsc () - start;
+  msg ("ohash: %llu cycles per lookup", cycles / (ROUNDS * PAGE_CNT));
+
+  /* Misses, as for an address with no page. */
+  start = rdtsc ();
+  for (i = 0; i < PAGE_CNT; i++) 
+    if (ohash_find (&ohash, pages[i].va + PGSIZE * PAGE_CNT) != NULL)
+      fail ("ohash_find found a page that is not there");
+  cycles = rdtsc () - start;
+  msg ("ohash misses: %llu cycles per lookup", cycles / PAGE_CNT);
+
+  for (i = 0; i < PAGE_CNT; i += 2)
+    ohash_delete (&ohash, &pages[i].ohash_elem);
+  for (i = 0; i < PAGE_CNT; i++)
+    if ((ohash_find (&ohash, pages[i].va) != NULL) != (i % 2 == 1))
+      fail ("ohash_delete removed the wrong pages");
+
+  msg ("%d pages looked up", PAGE_CNT);
+  hash_destroy (&hash, NULL);
+  ohash_destroy (&ohash, NULL);
+  palloc_free_multiple (pages, pg_cnt);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^\(hash-bench\) [a-z ]+: \d+ cycles per lookup$/,
+		@output);
+compare_output ("run", \@output, [<<'EOF']);
+(hash-bench) begin
+(hash-bench) 32768 pages looked up
+(hash-bench) end
+EOF
+pass;
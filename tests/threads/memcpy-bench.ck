@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^\(memcpy-bench\) [a-z_ ]+: \d+ cycles per page$/,
+		@output);
+compare_output ("run", \@output, [<<'EOF']);
+(memcpy-bench) begin
+(memcpy-bench) 16 pages copied and zeroed
+(memcpy-bench) end
+EOF
+pass;
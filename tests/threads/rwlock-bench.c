@@ -0,0 +1,124 @@
+/* Compares read-mostly throughput of a reader-writer lock against
+   a plain lock.  Several threads repeatedly take the lock for
+   reading and sleep for a tick inside the critical section, as a
+   reader blocked on the disk would.  A plain lock serializes those
+   sleeps; an rwlock lets them overlap.  A writer is mixed in every
+   few rounds so that the exclusive path is exercised too.
+
+   Timing lines vary from run to run and are ignored by the
+   checker; only the concurrency observations are compared. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+#define READER_CNT 8            /* Number of reader threads. */
+#define ROUNDS 10               /* Read sections per reader. */
+#define WRITE_EVERY 4           /* Reader 0 writes every this many rounds. */
+
+struct bench
+  {
+    bool use_rwlock;            /* Which lock the readers take. */
+    struct lock lock;
+    struct rwlock rwlock;
+    int inside;                 /* Readers currently inside. */
+    int max_inside;             /* Most readers seen inside at once. */
+    int writes;                 /* Completed write sections. */
+    struct semaphore done;      /* Upped by each finished reader. */
+  };
+
+static thread_func reader_thread;
+static void run_bench (struct bench *, bool use_rwlock);
+
+void
+test_rwlock_bench (void) 
+{
+  struct bench b;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  run_bench (&b, false);
+  msg ("lock: at most %d reader(s) inside", b.max_inside);
+  run_bench (&b, true);
+  msg ("rwlock: %s", b.max_inside > 1 ? "readers overlapped"
+                                       : "readers did not overlap");
+}
+
+static void
+run_bench (struct bench *b, bool use_rwlock) 
+{
+  int64_t start_ticks;
+  uint64_t start_tsc;
+  int i;
+
+  b->use_rwlock = use_rwlock;
+  lock_init (&b->lock);
+  rwlock_init (&b->rwlock);
+  b->inside = b->max_inside = b->writes = 0;
+  sema_init (&b->done, 0);
+
+  start_ticks = timer_ticks ();
+  start_tsc = rdtsc ();
+  for (i = 0; i < READER_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "reader %d", i);
+      thread_create (name, PRI_DEFAULT, reader_thread, b);
+    }
+  for (i = 0; i < READER_CNT; i++)
+    sema_down (&b->done);
+
+  if (b->writes != ROUNDS / WRITE_EVERY + 1)
+    fail ("expected %d writes, got %d", ROUNDS / WRITE_EVERY + 1, b->writes);
+  msg ("%s: %d reads, %d writes in %lld ticks, %llu kilocycles",
+       use_rwlock ? "rwlock" : "lock", READER_CNT * ROUNDS - b->writes,
+       b->writes, timer_elapsed (start_ticks),
+       (rdtsc () - start_tsc) / 1000);
+}
+
+static void
+reader_thread (void *b_) 
+{
+  struct bench *b = b_;
+  bool writer = !strcmp (thread_name (), "reader 0");
+  int i;
+
+  for (i = 0; i < ROUNDS; i++) 
+    {
+      if (writer && i % WRITE_EVERY == 0) 
+        {
+          if (b->use_rwlock)
+            rwlock_acquire_write (&b->rwlock);
+          else
+            lock_acquire (&b->lock);
+          if (b->inside != 0)
+            fail ("writer ran alongside %d reader(s)", b->inside);
+          b->writes++;
+          if (b->use_rwlock)
+            rwlock_release_write (&b->rwlock);
+          else
+            lock_release (&b->lock);
+          continue;
+        }
+
+      if (b->use_rwlock)
+        rwlock_acquire_read (&b->rwlock);
+      else
+        lock_acquire (&b->lock);
+      if (++b->inside > b->max_inside)
+        b->max_inside = b->inside;
+      timer_sleep (1);
+      b->inside--;
+      if (b->use_rwlock)
+        rwlock_release_read (&b->rwlock);
+      else
+        lock_release (&b->lock);
+    }
+  sema_up (&b->done);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^\(rwlock-bench\) (rw)?lock: \d+ reads, \d+ writes in \d+ ticks, \d+ kilocycles$/,
+		@output);
+compare_output ("run", \@output, [<<'EOF']);
+(rwlock-bench) begin
+(rwlock-bench) lock: at most 1 reader(s) inside
+(rwlock-bench) rwlock: readers overlapped
+(rwlock-bench) end
+EOF
+pass;
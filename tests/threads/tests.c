@@ -29,6 +29,12 @@ static const struct test tests[] =
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"rwlock-bench", test_rwlock_bench},
+    {"ctxsw-bench", test_ctxsw_bench},
+    {"yield-bench", test_yield_bench},
+    {"memcpy-bench", test_memcpy_bench},
+    {"hash-bench", test_hash_bench},
+    {"bitmap-bench", test_bitmap_bench},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
@@ -23,6 +23,12 @@ extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_condvar;
+extern test_func test_rwlock_bench;
+extern test_func test_ctxsw_bench;
+extern test_func test_yield_bench;
+extern test_func test_memcpy_bench;
+extern test_func test_hash_bench;
+extern test_func test_bitmap_bench;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
 extern test_func test_mlfqs_load_avg;
@@ -0,0 +1,56 @@
+/* Measures voluntary context switches.  Two threads of equal
+   priority call thread_yield() in a loop, so that every yield
+   switches to the other one.
+
+   Rates vary from run to run and are ignored by the checker. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+#define YIELDS 50000            /* Yields per thread. */
+
+static thread_func yielder_thread;
+
+void
+test_yield_bench (void) 
+{
+  struct semaphore done;
+  int64_t start_ticks, ticks;
+  uint64_t start_tsc, cycles;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+  thread_create ("yielder", thread_get_priority (), yielder_thread, &done);
+
+  start_ticks = timer_ticks ();
+  start_tsc = rdtsc ();
+  for (i = 0; i < YIELDS; i++)
+    thread_yield ();
+  sema_down (&done);
+  cycles = rdtsc () - start_tsc;
+  ticks = timer_elapsed (start_ticks);
+
+  msg ("%lld yields per second, %llu cycles per yield",
+       2LL * YIELDS * TIMER_FREQ / (ticks > 0 ? ticks : 1),
+       cycles / (2 * YIELDS));
+  msg ("%d yields completed", 2 * YIELDS);
+}
+
+static void
+yielder_thread (void *done_) 
+{
+  struct semaphore *done = done_;
+  int i;
+
+  for (i = 0; i < YIELDS; i++)
+    thread_yield ();
+  sema_up (done);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^\(yield-bench\) \d+ yields per second, \d+ cycles per yield$/,
+		@output);
+compare_output ("run", \@output, [<<'EOF']);
+(yield-bench) begin
+(yield-bench) 100000 yields completed
+(yield-bench) end
+EOF
+pass;
@@ -0,0 +1,37 @@
+/* Writes 16 kB of text to the console in 64-byte lines and
+   reports how fast the writes went, in bytes per million
+   cycles.  The lines themselves and the rate vary from run to
+   run and are ignored by the checker. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define LINE_CNT 256
+#define LINE_SIZE 64
+
+void
+test_main (void) 
+{
+  char line[LINE_SIZE + 1];
+  unsigned long long start, cycles;
+  int i;
+
+  start = rdtsc ();
+  for (i = 0; i < LINE_CNT; i++) 
+    {
+      snprintf (line, sizeof line, "console-bench line %04d %*s\n",
+                i, LINE_SIZE - 25, "");
+      if (write (STDOUT_FILENO, line, LINE_SIZE) != LINE_SIZE)
+        fail ("write %d came up short", i);
+    }
+  cycles = rdtsc () - start;
+  if (cycles == 0)
+    cycles = 1;
+
+  msg ("console write: %llu bytes per million cycles",
+       LINE_CNT * LINE_SIZE * 1000000ULL / cycles);
+  msg ("%d lines written", LINE_CNT);
+}
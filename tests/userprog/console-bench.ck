@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^console-bench line \d+ *$/, @output);
+@output = grep (!/^\(console-bench\) console write: \d+ bytes per million cycles$/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(console-bench) begin
+(console-bench) 256 lines written
+(console-bench) end
+console-bench: exit(0)
+EOF
+pass;
@@ -0,0 +1,37 @@
+/* Times repeated launches of child-simple.  The first launch parses
+   the executable and reads its text from disk; later ones should
+   find both cached.  Cycle counts vary from run to run and are
+   ignored by the checker. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ITERATIONS 10
+
+/* Runs child-simple to completion and returns the cycles it took. */
+static unsigned long long
+launch (void) 
+{
+  char *argv[] = {"child-simple", NULL};
+  unsigned long long start = rdtsc ();
+  pid_t pid = spawn ("child-simple", argv, NULL, 0);
+
+  if (pid <= 0)
+    fail ("spawn child-simple");
+  if (wait (pid) != 81)
+    fail ("wait for child-simple");
+  return rdtsc () - start;
+}
+
+void
+test_main (void) 
+{
+  unsigned long long total = 0;
+  int i;
+
+  msg ("first launch: %llu cycles", launch ());
+  for (i = 0; i < ITERATIONS; i++)
+    total += launch ();
+  msg ("repeat launch: %llu cycles", total / ITERATIONS);
+}
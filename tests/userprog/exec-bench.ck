@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^\(exec-bench\) .* launch: \d+ cycles$/, @output);
+my ($child) = <<'EOF';
+(child-simple) run
+child-simple: exit(81)
+EOF
+compare_output ("run", \@output, ["(exec-bench) begin\n"
+  . $child x 11 . <<'EOF']);
+(exec-bench) end
+exec-bench: exit(0)
+EOF
+pass;
@@ -0,0 +1,30 @@
+/* Opens one file more times than a fresh fd table has slots, so
+   the table must grow, then checks that a closed low descriptor
+   is the next one handed out. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define OPEN_CNT 600
+
+void
+test_main (void) 
+{
+  static int fds[OPEN_CNT];
+  int i;
+
+  for (i = 0; i < OPEN_CNT; i++) 
+    {
+      fds[i] = open ("sample.txt");
+      if (fds[i] < 2)
+        fail ("open #%d returned %d", i, fds[i]);
+      if (i > 0 && fds[i] != fds[i - 1] + 1)
+        fail ("open #%d returned %d after %d", i, fds[i], fds[i - 1]);
+    }
+  msg ("opened \"sample.txt\" %d times", OPEN_CNT);
+
+  close (fds[3]);
+  CHECK (open ("sample.txt") == fds[3], "lowest free fd is reused");
+  CHECK (filesize (fds[OPEN_CNT - 1]) > 0, "highest fd still works");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(open-many) begin
+(open-many) opened "sample.txt" 600 times
+(open-many) lowest free fd is reused
+(open-many) highest fd still works
+(open-many) end
+open-many: exit(0)
+EOF
+pass;
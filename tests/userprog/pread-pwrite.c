@@ -0,0 +1,30 @@
+/* Checks that pwrite() and pread() transfer at the given offset
+   without moving the file position. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[4];
+  int handle;
+
+  CHECK (create ("positional", 16), "create \"positional\"");
+  CHECK ((handle = open ("positional")) > 1, "open \"positional\"");
+  CHECK (write (handle, "0123456789abcdef", 16) == 16,
+         "write \"positional\"");
+  seek (handle, 2);
+
+  CHECK (pwrite (handle, "XY", 2, 4) == 2, "pwrite 2 bytes at offset 4");
+  CHECK (pread (handle, buf, 4, 3) == 4, "pread 4 bytes at offset 3");
+  if (memcmp (buf, "3XY6", 4))
+    fail ("pread() returned \"%.4s\" instead of \"3XY6\"", buf);
+  if (tell (handle) != 2)
+    fail ("position moved to %u", tell (handle));
+
+  CHECK (pread (handle, buf, 4, 14) == 2, "pread past end of file is short");
+  CHECK (pread (0, buf, 1, 0) == -1, "pread from the console fails");
+}
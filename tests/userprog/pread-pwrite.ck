@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-pwrite) begin
+(pread-pwrite) create "positional"
+(pread-pwrite) open "positional"
+(pread-pwrite) write "positional"
+(pread-pwrite) pwrite 2 bytes at offset 4
+(pread-pwrite) pread 4 bytes at offset 3
+(pread-pwrite) pread past end of file is short
+(pread-pwrite) pread from the console fails
+(pread-pwrite) end
+pread-pwrite: exit(0)
+EOF
+pass;
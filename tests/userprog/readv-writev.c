@@ -0,0 +1,39 @@
+/* Writes a file from three buffers with one writev() call, then
+   reads it back into two differently split buffers with readv(),
+   checking the file position after each. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  static char a[] = "vectored ", b[] = "i/o in ", c[] = "one call";
+  char head[12], tail[13];
+  struct iovec out[3] = {
+    {a, sizeof a - 1}, {b, sizeof b - 1}, {c, sizeof c - 1},
+  };
+  struct iovec in[2] = {{head, sizeof head}, {tail, sizeof tail}};
+  int handle, byte_cnt;
+
+  CHECK (create ("iovec", 24), "create \"iovec\"");
+  CHECK ((handle = open ("iovec")) > 1, "open \"iovec\"");
+
+  byte_cnt = writev (handle, out, 3);
+  if (byte_cnt != 24)
+    fail ("writev() returned %d instead of 24", byte_cnt);
+  if (tell (handle) != 24)
+    fail ("position after writev() is %u, not 24", tell (handle));
+
+  msg ("seek \"iovec\" to 0");
+  seek (handle, 0);
+  memset (tail, 0, sizeof tail);
+  byte_cnt = readv (handle, in, 2);
+  if (byte_cnt != 24)
+    fail ("readv() returned %d instead of 24", byte_cnt);
+  if (memcmp (head, "vectored i/o", 12) || strcmp (tail, " in one call"))
+    fail ("readv() read back the wrong data");
+  msg ("readv() matches writev()");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-writev) begin
+(readv-writev) create "iovec"
+(readv-writev) open "iovec"
+(readv-writev) seek "iovec" to 0
+(readv-writev) readv() matches writev()
+(readv-writev) end
+readv-writev: exit(0)
+EOF
+pass;
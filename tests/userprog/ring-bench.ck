@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^\(ring-bench\) (direct|ring): \d+ kilocycles$/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(ring-bench) begin
+(ring-bench) create "direct"
+(ring-bench) create "ring"
+(ring-bench) open "direct"
+(ring-bench) open "ring"
+(ring-bench) ring_setup
+(ring-bench) 10000 writes of 8 bytes each way
+(ring-bench) files match
+(ring-bench) end
+ring-bench: exit(0)
+EOF
+pass;
@@ -0,0 +1,48 @@
+/* Compares starting a child with spawn() against fork() followed
+   by exec(), then checks that spawn() hands the child only the
+   descriptors it was asked for: with fd 1 closed, child-simple
+   dies on its first write.  Cycle counts vary from run to run and
+   are ignored by the checker. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ITERATIONS 10
+
+void
+test_main (void) 
+{
+  static const struct spawn_fd no_stdout[] = {{-1, 1}};
+  char *argv[] = {"child-simple", NULL};
+  unsigned long long start;
+  pid_t pid;
+  int i;
+
+  start = rdtsc ();
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      if ((pid = spawn ("child-simple", argv, NULL, 0)) <= 0)
+        fail ("spawn child-simple");
+      if (wait (pid) != 81)
+        fail ("wait for child-simple");
+    }
+  msg ("spawn: %llu cycles per child", (rdtsc () - start) / ITERATIONS);
+
+  start = rdtsc ();
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      pid = fork ("forked");
+      if (pid == 0)
+        exec ("child-simple");
+      if (pid < 0)
+        fail ("fork");
+      if (wait (pid) != 81)
+        fail ("wait for forked");
+    }
+  msg ("fork+exec: %llu cycles per child", (rdtsc () - start) / ITERATIONS);
+
+  if ((pid = spawn ("child-simple", argv, no_stdout, 1)) <= 0)
+    fail ("spawn child-simple without fd 1");
+  CHECK (wait (pid) == -1, "child-simple without fd 1 exits -1");
+}
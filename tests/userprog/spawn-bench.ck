@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^\(spawn-bench\) .*: \d+ cycles per child$/, @output);
+my ($spawned) = <<'EOF';
+(child-simple) run
+child-simple: exit(81)
+EOF
+my ($forked) = <<'EOF';
+(child-simple) run
+forked: exit(81)
+EOF
+compare_output ("run", \@output, ["(spawn-bench) begin\n"
+  . $spawned x 10 . $forked x 10 . <<'EOF']);
+child-simple: exit(-1)
+(spawn-bench) child-simple without fd 1 exits -1
+(spawn-bench) end
+spawn-bench: exit(0)
+EOF
+pass;
@@ -0,0 +1,40 @@
+/* Times small system calls that pass user pointers into the
+   kernel: opening a file by name, and 16-byte reads and writes.
+   Cycle counts vary from run to run and are ignored by the
+   checker. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ITERATIONS 1000
+
+void
+test_main (void) 
+{
+  static char buf[16];
+  unsigned long long start;
+  int fd, i;
+
+  CHECK (create ("bench", sizeof buf), "create \"bench\"");
+  CHECK ((fd = open ("bench")) > 1, "open \"bench\"");
+
+  start = rdtsc ();
+  for (i = 0; i < ITERATIONS; i++)
+    close (open ("bench"));
+  msg ("open+close: %llu cycles per call", (rdtsc () - start) / ITERATIONS);
+
+  start = rdtsc ();
+  for (i = 0; i < ITERATIONS; i++)
+    if (pwrite (fd, buf, sizeof buf, 0) != sizeof buf)
+      fail ("pwrite %d came up short", i);
+  msg ("16-byte write: %llu cycles per call", (rdtsc () - start) / ITERATIONS);
+
+  start = rdtsc ();
+  for (i = 0; i < ITERATIONS; i++)
+    if (pread (fd, buf, sizeof buf, 0) != sizeof buf)
+      fail ("pread %d came up short", i);
+  msg ("16-byte read: %llu cycles per call", (rdtsc () - start) / ITERATIONS);
+
+  msg ("%d iterations of each call", ITERATIONS);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^\(syscall-bench\) .*: \d+ cycles per call$/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(syscall-bench) begin
+(syscall-bench) create "bench"
+(syscall-bench) open "bench"
+(syscall-bench) 1000 iterations of each call
+(syscall-bench) end
+syscall-bench: exit(0)
+EOF
+pass;
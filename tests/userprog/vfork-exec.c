@@ -0,0 +1,22 @@
+/* Vforks a child that execs child-simple, then waits for it.
+   The exec gives the parent its address space back intact. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[16] = "parent's stack";
+  int pid;
+
+  if ((pid = vfork ("child"))){
+    int status = wait (pid);
+    msg ("Parent: child exit status is %d", status);
+    msg ("Parent: buf holds \"%s\"", buf);
+  } else {
+    exec ("child-simple");
+    exit (-2);
+  }
+}
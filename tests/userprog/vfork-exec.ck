@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(vfork-exec) begin
+(child-simple) run
+child: exit(81)
+(vfork-exec) Parent: child exit status is 81
+(vfork-exec) Parent: buf holds "parent's stack"
+(vfork-exec) end
+vfork-exec: exit(0)
+EOF
+pass;
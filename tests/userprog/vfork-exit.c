@@ -0,0 +1,24 @@
+/* Vforks a child that writes to memory and exits.  The parent
+   must not run until the child is gone, and must then see the
+   child's write, since they shared one address space. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static volatile int shared;
+
+void
+test_main (void) 
+{
+  int pid;
+
+  if ((pid = vfork ("child"))){
+    msg ("Parent: shared is %d", shared);
+    msg ("Parent: child exit status is %d", wait (pid));
+  } else {
+    msg ("child run");
+    shared = 42;
+    exit (81);
+  }
+}
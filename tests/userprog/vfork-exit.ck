@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(vfork-exit) begin
+(vfork-exit) child run
+child: exit(81)
+(vfork-exit) Parent: shared is 42
+(vfork-exit) Parent: child exit status is 81
+(vfork-exit) end
+vfork-exit: exit(0)
+EOF
+pass;
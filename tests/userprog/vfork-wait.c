@@ -0,0 +1,23 @@
+/* Vforks several children in turn, then waits for them in
+   reverse order.  Each child is reaped exactly once. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 3
+
+void
+test_main (void) 
+{
+  int pids[CHILD_CNT];
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++)
+    if ((pids[i] = vfork ("child")) == 0)
+      exit (i + 10);
+
+  for (i = CHILD_CNT - 1; i >= 0; i--)
+    msg ("wait for child %d: %d", i, wait (pids[i]));
+  msg ("wait again for child 0: %d", wait (pids[0]));
+}
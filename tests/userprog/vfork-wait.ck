@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(vfork-wait) begin
+child: exit(10)
+child: exit(11)
+child: exit(12)
+(vfork-wait) wait for child 2: 12
+(vfork-wait) wait for child 1: 11
+(vfork-wait) wait for child 0: 10
+(vfork-wait) wait again for child 0: -1
+(vfork-wait) end
+vfork-wait: exit(0)
+EOF
+pass;
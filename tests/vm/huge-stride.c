@@ -0,0 +1,40 @@
+/* Touches one byte per page across 4 MB of memory, over and over,
+   so that nearly every access needs a different TLB entry.  With
+   2 MiB mappings the whole buffer needs only a few.  Cycle counts
+   vary from run to run and are ignored by the checker. */
+
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (4 * 1024 * 1024)
+#define STRIDE (4096 + 64)
+#define ROUNDS 20
+
+static char buf[SIZE];
+
+void
+test_main (void)
+{
+  unsigned long long start, accesses = 0;
+  unsigned sum = 0;
+  size_t i;
+  int round;
+
+  msg ("initialize");
+  memset (buf, 1, sizeof buf);
+
+  start = rdtsc ();
+  for (round = 0; round < ROUNDS; round++)
+    for (i = 0; i < SIZE; i += STRIDE)
+      {
+        sum += buf[i];
+        accesses++;
+      }
+  msg ("strided read: %llu cycles per access",
+       (rdtsc () - start) / accesses);
+
+  if (sum != accesses)
+    fail ("sum %u != %llu", sum, accesses);
+  msg ("read pass");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^\(huge-stride\) strided read: \d+ cycles per access$/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(huge-stride) begin
+(huge-stride) initialize
+(huge-stride) read pass
+(huge-stride) end
+huge-stride: exit(0)
+EOF
+pass;
@@ -0,0 +1,60 @@
+/* Fills many pages with the same bytes and then blocks on disk
+   reads for a while, which gives the page merging thread a chance
+   to fold them onto one frame.  Then writes a different byte into
+   each page and checks that every page kept its own contents.  How
+   many pages were merged depends on timing and is ignored by the
+   checker. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 32
+#define READS 200
+
+static char buf[PAGE_SIZE * PAGE_CNT] __attribute__ ((aligned (PAGE_SIZE)));
+
+/* Returns how many pages of BUF share a frame with page 0. */
+static int
+count_shared (void)
+{
+  void *first = get_phys_addr (buf);
+  int i, cnt = 0;
+
+  for (i = 1; i < PAGE_CNT; i++)
+    if (get_phys_addr (buf + i * PAGE_SIZE) == first)
+      cnt++;
+  return cnt;
+}
+
+void
+test_main (void)
+{
+  char block[512];
+  size_t i, j;
+  int fd;
+
+  memset (buf, 0x5a, sizeof buf);
+  msg ("filled %d pages", PAGE_CNT);
+
+  CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  for (i = 0; i < READS; i++)
+    {
+      seek (fd, 0);
+      read (fd, block, sizeof block);
+    }
+  close (fd);
+  msg ("%d pages merged with page 0", count_shared ());
+
+  for (i = 0; i < PAGE_CNT; i++)
+    buf[i * PAGE_SIZE] = i;
+  for (i = 0; i < PAGE_CNT; i++)
+    for (j = 0; j < PAGE_SIZE; j++)
+      if (buf[i * PAGE_SIZE + j] != (j == 0 ? (char) i : 0x5a))
+        fail ("page %zu byte %zu corrupted", i, j);
+  msg ("contents intact after writes");
+
+  CHECK (count_shared () == 0, "written pages no longer shared");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/^\(ksm-cow\) \d+ pages merged with page 0$/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(ksm-cow) begin
+(ksm-cow) filled 32 pages
+(ksm-cow) open "sample.txt"
+(ksm-cow) contents intact after writes
+(ksm-cow) written pages no longer shared
+(ksm-cow) end
+ksm-cow: exit(0)
+EOF
+pass;
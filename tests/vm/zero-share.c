@@ -0,0 +1,42 @@
+/* Reads a buffer that has never been written, which should map every
+   page of it to the same zero-filled frame, then writes one page and
+   checks that only that page gets a frame of its own. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 16
+
+static char buf[PAGE_SIZE * PAGE_CNT] __attribute__ ((aligned (PAGE_SIZE)));
+
+void
+test_main (void)
+{
+  void *zero;
+  size_t i, j;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    for (j = 0; j < PAGE_SIZE; j += 512)
+      if (buf[i * PAGE_SIZE + j] != 0)
+        fail ("page %zu not zero before write", i);
+
+  zero = get_phys_addr (buf);
+  CHECK (zero != NULL, "untouched pages are mapped");
+  for (i = 1; i < PAGE_CNT; i++)
+    if (get_phys_addr (buf + i * PAGE_SIZE) != zero)
+      fail ("page %zu does not share the zero frame", i);
+  msg ("untouched pages share one frame");
+
+  buf[PAGE_SIZE * 3] = 'x';
+  CHECK (get_phys_addr (buf + PAGE_SIZE * 3) != zero,
+         "written page has its own frame");
+
+  for (i = 0; i < PAGE_CNT; i++)
+    for (j = 0; j < PAGE_SIZE; j += 512)
+      if (buf[i * PAGE_SIZE + j] != (i == 3 && j == 0 ? 'x' : 0))
+        fail ("page %zu byte %zu corrupted", i, j);
+  msg ("other pages still read zero");
+}
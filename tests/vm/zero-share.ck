@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(zero-share) begin
+(zero-share) untouched pages are mapped
+(zero-share) untouched pages share one frame
+(zero-share) written page has its own frame
+(zero-share) other pages still read zero
+(zero-share) end
+zero-share: exit(0)
+EOF
+pass;
@@ -0,0 +1,15 @@
+#include "threads/cpu.h"
+#include <debug.h>
+
+struct cpu boot_cpu;
+
+/* Sets up the state of the boot CPU.  Called by thread_init(),
+   before the first lock is taken. */
+void
+cpu_init (void) {
+	struct cpu *c = &boot_cpu;
+
+	c->id = 0;
+	spin_init (&c->rq_lock);
+	list_init (&c->ready_list);
+}
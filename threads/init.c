@@ -13,6 +13,7 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
@@ -21,14 +22,17 @@
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
+#include "userprog/exec-cache.h"
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
 #endif
 #include "tests/threads/tests.h"
+#include "intrinsic.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
@@ -86,6 +90,7 @@ main (void) {
 	mem_end = palloc_init ();
 	malloc_init ();
 	paging_init (mem_end);
+	trace_init ();
 
 #ifdef USERPROG
 	tss_init ();
@@ -100,10 +105,12 @@ main (void) {
 #ifdef USERPROG
 	exception_init ();
 	syscall_init ();
+	exec_cache_init ();
 #endif
 	/* Start thread scheduler and enable interrupts. */
 	thread_start ();
 	serial_init_queue ();
+	console_start ();
 	timer_calibrate ();
 
 #ifdef FILESYS
@@ -165,6 +172,13 @@ paging_init (uint64_t mem_end) {
 
 	// reload cr3
 	pml4_activate(0);
+
+	/* Fault on kernel writes to read-only user pages as well, so that
+	 * copy_to_user() and friends break sharing of the zero page like
+	 * user writes do. */
+	lcr0 (rcr0 () | CR0_WP);
+
+	pcid_init ();
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -272,6 +286,7 @@ run_actions (char **argv) {
 		{"rm", 2, fsutil_rm},
 		{"put", 2, fsutil_put},
 		{"get", 2, fsutil_get},
+		{"trace", 2, trace_dump},
 #endif
 		{NULL, 0, NULL},
 	};
@@ -319,6 +334,7 @@ usage (void) {
 			"Use these actions indirectly via `pintos' -g and -p options:\n"
 			"  put FILE           Put FILE into file system from scratch disk.\n"
 			"  get FILE           Get FILE from file system into scratch disk.\n"
+			"  trace FILE         Dump the kernel trace into FILE.\n"
 #endif
 			"\nOptions:\n"
 			"  -h                 Print this help message and power off.\n"
@@ -345,6 +361,7 @@ power_off (void) {
 	print_stats ();
 
 	printf ("Powering off...\n");
+	console_flush ();
 	outw (0x604, 0x2000);               /* Poweroff command for qemu */
 	for (;;);
 }
@@ -354,6 +371,7 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+	palloc_print_stats ();
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
@@ -362,4 +380,7 @@ print_stats (void) {
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
+#ifdef VM
+	vm_print_stats ();
+#endif
 }
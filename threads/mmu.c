@@ -1,18 +1,42 @@
+#include <debug.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
+#include "threads/flags.h"
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "intrinsic.h"
 
+/* Process-context identifiers.  With CR4.PCIDE set, the TLB tags
+ * each entry with the PCID in the low bits of CR3, and a CR3 load
+ * with CR3_NOFLUSH set keeps the entries of every PCID.  Page tables
+ * are given PCIDs round robin as they are activated; PCID 0 belongs
+ * to base_pml4, whose user half is empty.  Changes to a page table
+ * that is not loaded mark its PCID stale, so that the next load
+ * flushes it. */
+#define PCID_CNT 64
+#define CR3_NOFLUSH (1ULL << 63)
+
+static bool pcid_enabled;
+static uint64_t *pcid_owner[PCID_CNT];
+static bool pcid_stale[PCID_CNT];
+static size_t pcid_next = 1;
+
+static size_t pcid_find (uint64_t *pml4);
+static void tlb_flush_page (uint64_t *pml4, const void *va);
+
 static uint64_t *
 pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 	int idx = PDX (va);
 	if (pdp) {
 		uint64_t *pte = (uint64_t *) pdp[idx];
+		/* A 2 MiB mapping has no PTEs; callers split it first. */
+		if ((uint64_t) pte & PTE_PS)
+			return NULL;
 		if (!((uint64_t) pte & PTE_P)) {
 			if (create) {
 				uint64_t *new_page = palloc_get_page (PAL_ZERO);
@@ -88,6 +112,46 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 	return pte;
 }
 
+/* Returns the page directory entry for VA in PML4, or a null
+ * pointer if there is no page directory for VA.  With CREATE, the
+ * directory is created if need be, but no page table below it. */
+static uint64_t *
+pde_walk (uint64_t *pml4, const uint64_t va, int create) {
+	uint64_t *table = pml4;
+	int level_idx[2] = { PML4 (va), PDPE (va) };
+
+	for (int i = 0; i < 2; i++) {
+		uint64_t *entry = &table[level_idx[i]];
+		if (!(*entry & PTE_P)) {
+			uint64_t *new_page;
+			if (!create || (new_page = palloc_get_page (PAL_ZERO)) == NULL)
+				return NULL;
+			*entry = vtop (new_page) | PTE_U | PTE_W | PTE_P;
+		}
+		table = ptov (PTE_ADDR (*entry));
+	}
+	return &table[PDX (va)];
+}
+
+/* Returns the directory entry mapping UADDR as part of a 2 MiB
+ * page, or a null pointer if UADDR is not in one. */
+static uint64_t *
+huge_pde (uint64_t *pml4, const void *uaddr) {
+	uint64_t *pde = pde_walk (pml4, (uint64_t) uaddr, false);
+	if (pde != NULL && (*pde & PTE_P) && (*pde & PTE_PS))
+		return pde;
+	return NULL;
+}
+
+/* Splits a 2 MiB mapping into 4 KiB PTEs for the callers below that
+ * work on single pages.  Returns false, leaving the mapping whole,
+ * if there is no memory for the page table. */
+static bool
+split_if_huge (uint64_t *pml4, const void *uaddr) {
+	return huge_pde (pml4, uaddr) == NULL
+		|| pml4_split_huge_page (pml4, (void *) uaddr);
+}
+
 /* Creates a new page map level 4 (pml4) has mappings for kernel
  * virtual addresses, but none for user virtual addresses.
  * Returns the new page directory, or a null pointer if memory
@@ -96,7 +160,7 @@ uint64_t *
 pml4_create (void) {
 	uint64_t *pml4 = palloc_get_page (0);
 	if (pml4)
-		memcpy (pml4, base_pml4, PGSIZE);
+		page_copy (pml4, base_pml4);
 	return pml4;
 }
 
@@ -122,7 +186,7 @@ pgdir_for_each (uint64_t *pdp, pte_for_each_func *func, void *aux,
 		unsigned pml4_index, unsigned pdp_index) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
+		if ((((uint64_t) pte) & PTE_P) && !(((uint64_t) pte) & PTE_PS))
 			if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
 					pml4_index, pdp_index, i))
 				return false;
@@ -169,7 +233,9 @@ static void
 pgdir_destroy (uint64_t *pdp) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
+		if ((((uint64_t) pte) & PTE_P) && (((uint64_t) pte) & PTE_PS))
+			palloc_free_multiple ((void *) PTE_ADDR (pte), HPAGE_PGCNT);
+		else if (((uint64_t) pte) & PTE_P)
 			pt_destroy (PTE_ADDR (pte));
 	}
 	palloc_free_page ((void *) pdp);
@@ -192,6 +258,16 @@ pml4_destroy (uint64_t *pml4) {
 		return;
 	ASSERT (pml4 != base_pml4);
 
+	/* A page table allocated here later must not inherit the
+	 * PCID, and with it any TLB entries, of this one. */
+	if (pcid_enabled) {
+		enum intr_level old_level = intr_disable ();
+		size_t pcid = pcid_find (pml4);
+		if (pcid != 0)
+			pcid_owner[pcid] = NULL;
+		intr_set_level (old_level);
+	}
+
 	/* if PML4 (vaddr) >= 1, it's kernel space by define. */
 	uint64_t *pdpe = ptov ((uint64_t *) pml4[0]);
 	if (((uint64_t) pdpe) & PTE_P)
@@ -199,11 +275,89 @@ pml4_destroy (uint64_t *pml4) {
 	palloc_free_page ((void *) pml4);
 }
 
+/* Turns on PCIDs if the CPU has them. */
+void
+pcid_init (void) {
+	uint32_t eax, ebx, ecx, edx;
+
+	cpuid (1, 0, &eax, &ebx, &ecx, &edx);
+	if (!(ecx & CPUID_1_ECX_PCID))
+		return;
+
+	/* Only allowed while CR3 names PCID 0. */
+	ASSERT ((rcr3 () & PGMASK) == 0);
+	lcr4 (rcr4 () | CR4_PCIDE);
+	pcid_enabled = true;
+}
+
+/* Returns the PCID held by PML4, or 0 if it has none. */
+static size_t
+pcid_find (uint64_t *pml4) {
+	size_t i;
+
+	for (i = 1; i < PCID_CNT; i++)
+		if (pcid_owner[i] == pml4)
+			return i;
+	return 0;
+}
+
+/* Returns true if PML4 is the page table the CPU is using. */
+bool
+pml4_is_active (uint64_t *pml4) {
+	return PTE_ADDR (rcr3 ()) == vtop (pml4);
+}
+
+/* Drops the TLB entry for user page VA in PML4: right away if PML4
+ * is loaded, otherwise at the next pml4_activate() of it. */
+static void
+tlb_flush_page (uint64_t *pml4, const void *va) {
+	enum intr_level old_level;
+	size_t pcid;
+
+	old_level = intr_disable ();
+	if (pml4_is_active (pml4))
+		invlpg ((uint64_t) va);
+	else if (pcid_enabled && (pcid = pcid_find (pml4)) != 0)
+		pcid_stale[pcid] = true;
+	intr_set_level (old_level);
+}
+
 /* Loads page directory PD into the CPU's page directory base
- * register. */
+ * register.  Does nothing if it is loaded already.  With PCIDs,
+ * switching keeps the TLB entries of PD and of other page tables,
+ * unless PD has changed since it was last loaded. */
 void
 pml4_activate (uint64_t *pml4) {
-	lcr3 (vtop (pml4 ? pml4 : base_pml4));
+	enum intr_level old_level;
+	uint64_t cr3;
+	size_t pcid;
+
+	if (pml4 == NULL)
+		pml4 = base_pml4;
+	if (!pcid_enabled) {
+		if (!pml4_is_active (pml4))
+			lcr3 (vtop (pml4));
+		return;
+	}
+
+	old_level = intr_disable ();
+	if (pml4 == base_pml4)
+		cr3 = vtop (pml4) | CR3_NOFLUSH;
+	else if ((pcid = pcid_find (pml4)) != 0) {
+		cr3 = vtop (pml4) | pcid | (pcid_stale[pcid] ? 0 : CR3_NOFLUSH);
+		pcid_stale[pcid] = false;
+	} else {
+		/* Take over the next PCID, flushing what its last owner
+		 * left behind. */
+		pcid = pcid_next;
+		pcid_next = pcid_next % (PCID_CNT - 1) + 1;
+		pcid_owner[pcid] = pml4;
+		pcid_stale[pcid] = false;
+		cr3 = vtop (pml4) | pcid;
+	}
+	if ((cr3 & ~CR3_NOFLUSH) != rcr3 () || !(cr3 & CR3_NOFLUSH))
+		lcr3 (cr3);
+	intr_set_level (old_level);
 }
 
 /* Looks up the physical address that corresponds to user virtual
@@ -214,6 +368,10 @@ void *
 pml4_get_page (uint64_t *pml4, const void *uaddr) {
 	ASSERT (is_user_vaddr (uaddr));
 
+	uint64_t *pde = huge_pde (pml4, uaddr);
+	if (pde != NULL)
+		return ptov (PTE_ADDR (*pde)) + ((uint64_t) uaddr & (HPAGE_SIZE - 1));
+
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
 
 	if (pte && (*pte & PTE_P))
@@ -236,30 +394,41 @@ pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
 	ASSERT (is_user_vaddr (upage));
 	ASSERT (pml4 != base_pml4);
 
+	if (huge_pde (pml4, upage) != NULL
+			&& !pml4_split_huge_page (pml4, upage))
+		return false;
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) upage, 1);
 
-	if (pte)
+	if (pte) {
+		bool was_present = (*pte & PTE_P) != 0;
 		*pte = vtop (kpage) | PTE_P | (rw ? PTE_W : 0) | PTE_U;
+		if (was_present)
+			tlb_flush_page (pml4, upage);
+	}
 	return pte != NULL;
 }
 
 /* Marks user virtual page UPAGE "not present" in page
  * directory PD.  Later accesses to the page will fault.  Other
  * bits in the page table entry are preserved.
- * UPAGE need not be mapped. */
-void
+ * UPAGE need not be mapped.  Returns false, leaving UPAGE mapped,
+ * if it lies in a 2 MiB mapping that cannot be split for lack of
+ * memory. */
+bool
 pml4_clear_page (uint64_t *pml4, void *upage) {
 	uint64_t *pte;
 	ASSERT (pg_ofs (upage) == 0);
 	ASSERT (is_user_vaddr (upage));
 
+	if (!split_if_huge (pml4, upage))
+		return false;
 	pte = pml4e_walk (pml4, (uint64_t) upage, false);
 
 	if (pte != NULL && (*pte & PTE_P) != 0) {
 		*pte &= ~PTE_P;
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) upage);
+		tlb_flush_page (pml4, upage);
 	}
+	return true;
 }
 
 /* Returns true if the PTE for virtual page VPAGE in PML4 is dirty,
@@ -268,23 +437,30 @@ pml4_clear_page (uint64_t *pml4, void *upage) {
  * Returns false if PML4 contains no PTE for VPAGE. */
 bool
 pml4_is_dirty (uint64_t *pml4, const void *vpage) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	uint64_t *pte = huge_pde (pml4, vpage);
+	if (pte == NULL)
+		pte = pml4e_walk (pml4, (uint64_t) vpage, false);
 	return pte != NULL && (*pte & PTE_D) != 0;
 }
 
 /* Set the dirty bit to DIRTY in the PTE for virtual page VPAGE
- * in PML4. */
+ * in PML4.  In a 2 MiB mapping that cannot be split, a bit being
+ * set goes on the whole mapping and one being cleared stays, which
+ * only errs toward extra write-back. */
 void
 pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	uint64_t *pte;
+	if (split_if_huge (pml4, vpage))
+		pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	else
+		pte = dirty ? huge_pde (pml4, vpage) : NULL;
 	if (pte) {
 		if (dirty)
 			*pte |= PTE_D;
 		else
 			*pte &= ~(uint32_t) PTE_D;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		tlb_flush_page (pml4, vpage);
 	}
 }
 
@@ -294,22 +470,95 @@ pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
  * PML4 contains no PTE for VPAGE. */
 bool
 pml4_is_accessed (uint64_t *pml4, const void *vpage) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	uint64_t *pte = huge_pde (pml4, vpage);
+	if (pte == NULL)
+		pte = pml4e_walk (pml4, (uint64_t) vpage, false);
 	return pte != NULL && (*pte & PTE_A) != 0;
 }
 
 /* Sets the accessed bit to ACCESSED in the PTE for virtual page
-   VPAGE in PD. */
+   VPAGE in PD.  Like pml4_set_dirty() for a 2 MiB mapping that
+   cannot be split. */
 void
 pml4_set_accessed (uint64_t *pml4, const void *vpage, bool accessed) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	uint64_t *pte;
+	if (split_if_huge (pml4, vpage))
+		pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	else
+		pte = accessed ? huge_pde (pml4, vpage) : NULL;
 	if (pte) {
 		if (accessed)
 			*pte |= PTE_A;
 		else
 			*pte &= ~(uint32_t) PTE_A;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		tlb_flush_page (pml4, vpage);
+	}
+}
+
+/* Maps the 2 MiB-aligned user region at UPAGE to the 2 MiB of
+ * physically contiguous, 2 MiB-aligned memory at KPAGE with a single
+ * page directory entry.  Nothing in the region may be mapped yet;
+ * an empty page table left over there is freed.  Returns false if
+ * part of the region is mapped or memory allocation failed. */
+bool
+pml4_set_huge_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
+	ASSERT (((uint64_t) upage & (HPAGE_SIZE - 1)) == 0);
+	ASSERT ((vtop (kpage) & (HPAGE_SIZE - 1)) == 0);
+	ASSERT (is_user_vaddr (upage));
+	ASSERT (pml4 != base_pml4);
+
+	uint64_t *pde = pde_walk (pml4, (uint64_t) upage, true);
+	uint64_t *pt = NULL;
+	if (pde == NULL)
+		return false;
+	if (*pde & PTE_P) {
+		if (*pde & PTE_PS)
+			return false;
+		pt = ptov (PTE_ADDR (*pde));
+		for (size_t i = 0; i < HPAGE_PGCNT; i++)
+			if (pt[i] & PTE_P)
+				return false;
 	}
+	*pde = vtop (kpage) | PTE_PS | PTE_P | (rw ? PTE_W : 0) | PTE_U;
+
+	/* The CPU may still cache the old entry that pointed at PT, so
+	 * drop it before PT can be reused. */
+	if (pt != NULL) {
+		tlb_flush_page (pml4, upage);
+		palloc_free_page (pt);
+	}
+	return true;
+}
+
+/* Replaces the 2 MiB mapping covering UPAGE with a page table of 512
+ * PTEs that map the same memory with the same permissions, so that
+ * each 4 KiB piece can be unmapped, evicted or changed on its own.
+ * Does nothing if UPAGE is not in a 2 MiB mapping.  Returns false if
+ * the page table cannot be allocated. */
+bool
+pml4_split_huge_page (uint64_t *pml4, void *upage) {
+	uint64_t *pde = huge_pde (pml4, upage);
+	uint64_t *pt;
+
+	if (pde == NULL)
+		return true;
+	pt = palloc_get_page (0);
+	if (pt == NULL)
+		return false;
+
+	uint64_t flags = *pde & (PTE_P | PTE_W | PTE_U | PTE_A | PTE_D);
+	for (size_t i = 0; i < HPAGE_PGCNT; i++)
+		pt[i] = (PTE_ADDR (*pde) + i * PGSIZE) | flags;
+	*pde = vtop (pt) | PTE_U | PTE_W | PTE_P;
+
+	/* One INVLPG anywhere in the region drops the 2 MiB TLB entry. */
+	tlb_flush_page (pml4, (void *) ((uint64_t) upage & ~(HPAGE_SIZE - 1)));
+	return true;
+}
+
+/* Returns true if UADDR is mapped as part of a 2 MiB page. */
+bool
+pml4_is_huge (uint64_t *pml4, const void *uaddr) {
+	return huge_pde (pml4, uaddr) != NULL;
 }
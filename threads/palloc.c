@@ -38,6 +38,24 @@ static struct pool kernel_pool, user_pool;
 
 /* Maximum number of pages to put in user pool. */
 size_t user_page_limit = SIZE_MAX;
+
+/* User pages the idle thread has already zeroed.  They are marked
+   used in the user pool's bitmap, so they count as allocated until
+   handed out: PAL_USER | PAL_ZERO requests take them first, and any
+   single-page user request falls back on them once the pool runs
+   dry. */
+#define PREZERO_MAX 64
+static void *prezeroed[PREZERO_MAX];
+static size_t prezeroed_cnt;
+static size_t prezero_claimed;    /* Slots held for pages being zeroed. */
+static struct spinlock prezero_lock;
+
+/* Statistics. */
+static long long prezero_hits;    /* PAL_ZERO requests served pre-zeroed. */
+static long long prezero_misses;  /* PAL_ZERO requests zeroed on the spot. */
+static long long prezero_fills;   /* Pages zeroed by the idle thread. */
+
+static void *prezeroed_pop (void);
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
@@ -243,6 +261,7 @@ palloc_init (void) {
 	struct area base_mem = { .size = 0 };
 	struct area ext_mem = { .size = 0 };
 
+	spin_init (&prezero_lock);
 	resolve_area_info (&base_mem, &ext_mem);
 	printf ("Pintos booting with: \n");
 	printf ("\tbase_mem: 0x%llx ~ 0x%llx (Usable: %'llu kB)\n",
@@ -262,6 +281,16 @@ palloc_init (void) {
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	bool single_user = pool == &user_pool && page_cnt == 1;
+
+	if (single_user && (flags & PAL_ZERO)) {
+		void *page = prezeroed_pop ();
+		if (page != NULL) {
+			prezero_hits++;
+			return page;
+		}
+		prezero_misses++;
+	}
 
 	lock_acquire (&pool->lock);
 	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
@@ -270,12 +299,15 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 
 	if (page_idx != BITMAP_ERROR)
 		pages = pool->base + PGSIZE * page_idx;
+	else if (single_user)
+		pages = prezeroed_pop ();
 	else
 		pages = NULL;
 
 	if (pages) {
 		if (flags & PAL_ZERO)
-			memset (pages, 0, PGSIZE * page_cnt);
+			for (size_t i = 0; i < page_cnt; i++)
+				page_zero (pages + PGSIZE * i);
 	} else {
 		if (flags & PAL_ASSERT)
 			PANIC ("palloc_get: out of pages");
@@ -284,6 +316,43 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	return pages;
 }
 
+/* Like palloc_get_multiple(), but the pages returned start at a
+   physical address that is a multiple of PAGE_CNT pages, which
+   must be a power of two.  Used for 2 MiB mappings, which need
+   their memory both contiguous and aligned. */
+void *
+palloc_get_aligned (enum palloc_flags flags, size_t page_cnt) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	size_t pool_cnt = bitmap_size (pool->used_map);
+	size_t page_idx;
+	void *pages = NULL;
+
+	ASSERT (page_cnt > 0 && (page_cnt & (page_cnt - 1)) == 0);
+
+	/* Kernel virtual addresses are physical plus a 2 MiB-aligned
+	   offset, so aligning the page number aligns both. */
+	page_idx = ROUND_UP (pg_no (pool->base), page_cnt) - pg_no (pool->base);
+
+	lock_acquire (&pool->lock);
+	for (; page_idx + page_cnt <= pool_cnt; page_idx += page_cnt)
+		if (!bitmap_contains (pool->used_map, page_idx, page_cnt, true)) {
+			bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+			pages = pool->base + PGSIZE * page_idx;
+			break;
+		}
+	lock_release (&pool->lock);
+
+	if (pages) {
+		if (flags & PAL_ZERO)
+			for (size_t i = 0; i < page_cnt; i++)
+				page_zero (pages + PGSIZE * i);
+	} else {
+		if (flags & PAL_ASSERT)
+			PANIC ("palloc_get: out of pages");
+	}
+	return pages;
+}
+
 /* Obtains a single free page and returns its kernel virtual
    address.
    If PAL_USER is set, the page is obtained from the user pool,
@@ -328,6 +397,89 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Zeroes one free user page ahead of demand.  Called by the idle
+   thread, which must not sleep, so this gives up rather than wait
+   for the pool lock.  A slot on the stack is claimed first, so a
+   zeroed page always has somewhere to go.  Returns false if there
+   is nothing to do right now. */
+bool
+palloc_prezero (void) {
+	struct pool *pool = &user_pool;
+	size_t page_idx = BITMAP_ERROR;
+	void *page;
+
+	spin_lock (&prezero_lock);
+	if (prezeroed_cnt + prezero_claimed >= PREZERO_MAX) {
+		spin_unlock (&prezero_lock);
+		return false;
+	}
+	prezero_claimed++;
+	spin_unlock (&prezero_lock);
+
+	if (lock_try_acquire (&pool->lock)) {
+		page_idx = bitmap_scan_and_flip (pool->used_map, 0, 1, false);
+		lock_release (&pool->lock);
+	}
+	if (page_idx == BITMAP_ERROR) {
+		spin_lock (&prezero_lock);
+		prezero_claimed--;
+		spin_unlock (&prezero_lock);
+		return false;
+	}
+
+	page = pool->base + PGSIZE * page_idx;
+	page_zero (page);
+
+	spin_lock (&prezero_lock);
+	prezero_claimed--;
+	prezeroed[prezeroed_cnt++] = page;
+	prezero_fills++;
+	spin_unlock (&prezero_lock);
+	return true;
+}
+
+/* Takes a page off the pre-zeroed stack, or returns NULL if it is
+   empty. */
+static void *
+prezeroed_pop (void) {
+	void *page = NULL;
+
+	spin_lock (&prezero_lock);
+	if (prezeroed_cnt > 0)
+		page = prezeroed[--prezeroed_cnt];
+	spin_unlock (&prezero_lock);
+	return page;
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void) {
+	printf ("Palloc: %lld pre-zeroed hits, %lld misses, %lld pages zeroed while idle\n",
+			prezero_hits, prezero_misses, prezero_fills);
+}
+
+/* Copies the page at SRC to DST.  Both must be page-aligned.
+   Whole aligned pages suit the CPU's fast-string microcode, which
+   moves them a cache line at a time. */
+void
+page_copy (void *dst, const void *src) {
+	size_t words = PGSIZE / sizeof (uint64_t);
+
+	ASSERT (pg_ofs (dst) == 0 && pg_ofs (src) == 0);
+	asm volatile ("rep movsq"
+			: "+D" (dst), "+S" (src), "+c" (words) : : "memory");
+}
+
+/* Fills the page at PAGE, which must be page-aligned, with zeros. */
+void
+page_zero (void *page) {
+	size_t words = PGSIZE / sizeof (uint64_t);
+
+	ASSERT (pg_ofs (page) == 0);
+	asm volatile ("rep stosq"
+			: "+D" (page), "+c" (words) : "a" (0) : "memory");
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
@@ -31,6 +31,7 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/cpu.h"
 
 void donate_priority(void);
 static struct list_elem *list_find(struct list *list, struct list_elem *elem);
@@ -112,6 +113,7 @@ void sema_up(struct semaphore *sema)
 
 	ASSERT(sema != NULL);
 	struct thread *next_holder = NULL;
+	bool donation_lost = false;
 	old_level = intr_disable();
 	if (!list_empty(&sema->waiters))
 	{
@@ -127,18 +129,11 @@ void sema_up(struct semaphore *sema)
 			if (list_find(&curr->donations, &waiter_thread->donation_elem))
 			{
 				list_remove(&waiter_thread->donation_elem);
-
-				if (list_empty(&curr->donations))
-				{
-					curr->priority = curr->priority_origin;
-					break;
-				}
-
-				struct list_elem *donation_max_elem = list_max(&curr->donations, compare, NULL);
-				struct thread *donation_max_thread = list_entry(donation_max_elem, struct thread, donation_elem);
-				curr->priority = donation_max_thread->priority;
+				donation_lost = true;
 			}
 		}
+		if (donation_lost)
+			thread_refresh_priority();
 
 		list_remove(max_elem);
 
@@ -316,6 +311,288 @@ bool lock_held_by_current_thread(const struct lock *lock)
 	return lock->holder == thread_current();
 }
 
+/* Initializes RWLOCK.  Readers share the lock; a writer gets it
+   exclusively.
+
+   The writer side is an ordinary lock, so a writer holding it (or
+   draining readers while holding it) receives priority donation
+   from every higher-priority reader or writer that queues behind
+   it.  Readers only hold the inner lock long enough to bump the
+   reader count, which is what gives writers preference: once a
+   writer owns the inner lock, newly arriving readers wait.
+
+   A writer draining readers donates its priority to the readers
+   still inside, which are remembered in HOLDERS.  Only the first
+   RWLOCK_HOLDERS readers at a time are remembered; any beyond
+   that go without donation.  Each donation is kept in the
+   reader's rw_donations until it leaves, so that leaving one
+   rwlock does not cost it what other locks and rwlocks gave it. */
+void rwlock_init(struct rwlock *rw)
+{
+	ASSERT(rw != NULL);
+
+	lock_init(&rw->lock);
+	rw->readers = 0;
+	rw->writer_waiting = false;
+	sema_init(&rw->drain, 0);
+	memset(rw->holders, 0, sizeof rw->holders);
+}
+
+/* Records the current thread as a reader inside RW, if there is a
+   free slot for it.  Interrupts must be off. */
+static void rwlock_track_reader(struct rwlock *rw)
+{
+	int i;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	rw->readers++;
+	for (i = 0; i < RWLOCK_HOLDERS; i++)
+		if (rw->holders[i].thread == NULL)
+		{
+			rw->holders[i].thread = thread_current();
+			rw->holders[i].donated = false;
+			break;
+		}
+}
+
+/* Forgets the current thread as a reader inside RW, along with any
+   donation it got from RW's writer.  Returns true if there was
+   one.  Interrupts must be off. */
+static bool rwlock_untrack_reader(struct rwlock *rw)
+{
+	bool donated = false;
+	int i;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	rw->readers--;
+	for (i = 0; i < RWLOCK_HOLDERS; i++)
+	{
+		struct rwlock_holder *h = &rw->holders[i];
+
+		if (h->thread == thread_current())
+		{
+			donated = h->donated;
+			if (donated)
+				list_remove(&h->elem);
+			h->thread = NULL;
+			h->donated = false;
+			break;
+		}
+	}
+	return donated;
+}
+
+/* Donates the current thread's priority to each reader inside RW
+   and on down the chain of locks that reader is waiting for, as
+   donate_priority() does for an ordinary lock.  Interrupts must be
+   off. */
+static void rwlock_donate_to_readers(struct rwlock *rw)
+{
+	int priority = thread_current()->priority;
+	int i;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	for (i = 0; i < RWLOCK_HOLDERS; i++)
+	{
+		struct rwlock_holder *h = &rw->holders[i];
+		struct thread *t = h->thread;
+
+		if (t == NULL)
+			continue;
+		if (!h->donated)
+		{
+			h->donated = true;
+			h->donation = priority;
+			list_push_back(&t->rw_donations, &h->elem);
+		}
+		else if (h->donation < priority)
+			h->donation = priority;
+
+		while (t != NULL && t->priority < priority)
+		{
+			thread_raise_priority(t, priority);
+			t = t->wait_on_lock != NULL ? t->wait_on_lock->holder : NULL;
+		}
+	}
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or is
+   waiting for it. */
+void rwlock_acquire_read(struct rwlock *rw)
+{
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(!intr_context());
+
+	lock_acquire(&rw->lock);
+	old_level = intr_disable();
+	rwlock_track_reader(rw);
+	intr_set_level(old_level);
+	lock_release(&rw->lock);
+}
+
+/* Tries to acquire RW for reading without sleeping.  Returns true
+   if successful. */
+bool rwlock_try_acquire_read(struct rwlock *rw)
+{
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+
+	if (!lock_try_acquire(&rw->lock))
+		return false;
+	old_level = intr_disable();
+	rwlock_track_reader(rw);
+	intr_set_level(old_level);
+	lock_release(&rw->lock);
+	return true;
+}
+
+/* Releases a read hold on RW.  A reader leaving while a writer
+   drains gives back the writer's donation, and the last reader out
+   wakes the writer.  Like lock_release(), yields if that leaves a
+   higher-priority thread ready. */
+void rwlock_release_read(struct rwlock *rw)
+{
+	enum intr_level old_level;
+	bool donated;
+
+	ASSERT(rw != NULL);
+	ASSERT(rw->readers > 0);
+
+	old_level = intr_disable();
+	donated = rwlock_untrack_reader(rw);
+	if (donated)
+		thread_refresh_priority();
+	if (rw->writer_waiting && rw->readers == 0)
+	{
+		rw->writer_waiting = false;
+		sema_up(&rw->drain);
+	}
+	intr_set_level(old_level);
+
+	if (donated && !intr_context() && thread_get_priority() < next_thread_priority())
+		thread_yield();
+}
+
+/* Acquires RW for writing.  Takes the inner lock first, which
+   stops new readers, then waits for readers already inside to
+   leave. */
+void rwlock_acquire_write(struct rwlock *rw)
+{
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(!intr_context());
+
+	lock_acquire(&rw->lock);
+
+	old_level = intr_disable();
+	if (rw->readers > 0)
+	{
+		rw->writer_waiting = true;
+		rwlock_donate_to_readers(rw);
+		sema_down(&rw->drain);
+	}
+	intr_set_level(old_level);
+}
+
+/* Tries to acquire RW for writing without sleeping.  Fails if any
+   reader or writer holds it. */
+bool rwlock_try_acquire_write(struct rwlock *rw)
+{
+	ASSERT(rw != NULL);
+
+	if (!lock_try_acquire(&rw->lock))
+		return false;
+	if (rw->readers > 0)
+	{
+		lock_release(&rw->lock);
+		return false;
+	}
+	return true;
+}
+
+/* Releases RW, which the current thread must hold for writing. */
+void rwlock_release_write(struct rwlock *rw)
+{
+	ASSERT(rw != NULL);
+	ASSERT(rw->readers == 0);
+
+	lock_release(&rw->lock);
+}
+
+/* Returns true if the current thread holds RW for writing. */
+bool rwlock_held_for_write(const struct rwlock *rw)
+{
+	ASSERT(rw != NULL);
+
+	return lock_held_by_current_thread(&rw->lock);
+}
+
+/* Initializes spinlock S to the released state. */
+void spin_init(struct spinlock *s)
+{
+	ASSERT(s != NULL);
+
+	s->locked = 0;
+	s->holder = NULL;
+}
+
+/* Tries to take S once with interrupts off.  On failure the
+   interrupt level is restored and false is returned. */
+bool spin_try_lock(struct spinlock *s)
+{
+	enum intr_level old_level;
+
+	ASSERT(s != NULL);
+	ASSERT(!spin_held(s));
+
+	old_level = intr_disable();
+	if (__atomic_exchange_n(&s->locked, 1, __ATOMIC_ACQUIRE))
+	{
+		intr_set_level(old_level);
+		return false;
+	}
+	s->holder = this_cpu();
+	s->old_level = old_level;
+	return true;
+}
+
+/* Takes S, spinning until the CPU holding it lets go. */
+void spin_lock(struct spinlock *s)
+{
+	while (!spin_try_lock(s))
+		while (s->locked)
+			asm volatile("pause");
+}
+
+/* Releases S, which this CPU must hold, and restores the interrupt
+   level from before spin_lock(). */
+void spin_unlock(struct spinlock *s)
+{
+	enum intr_level old_level;
+
+	ASSERT(spin_held(s));
+
+	old_level = s->old_level;
+	s->holder = NULL;
+	__atomic_store_n(&s->locked, 0, __ATOMIC_RELEASE);
+	intr_set_level(old_level);
+}
+
+/* Returns true if this CPU holds S. */
+bool spin_held(const struct spinlock *s)
+{
+	ASSERT(s != NULL);
+
+	return s->locked && s->holder == this_cpu();
+}
+
 /* One semaphore in a list. */
 struct semaphore_elem
 {
@@ -4,11 +4,14 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/switch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 #include "intrinsic.h"
 #include "hash.h"
@@ -18,6 +21,7 @@
 
 #ifdef USERPROG
 #include "userprog/process.h"
+#include "userprog/syscall.h"
 #endif
 
 /* Random value for struct thread's `magic' member.
@@ -29,14 +33,11 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running, wait in the ready_list of
+   the CPU they last ran on; see threads/cpu.h. */
 static struct list block_list;
 
-/* Idle thread. */
-static struct thread *idle_thread;
-
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
@@ -46,14 +47,8 @@ static struct lock tid_lock;
 /* Thread destruction requests */
 static struct list destruction_req;
 
-/* Statistics. */
-static long long idle_ticks;    /* # of timer ticks spent idle. */
-static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
-static long long user_ticks;    /* # of timer ticks in user programs. */
-
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
-static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
@@ -112,14 +107,15 @@ thread_init (void) {
 	lgdt (&gdt_ds);
 
 	/* Init the globla thread context */
+	cpu_init ();
 	lock_init (&tid_lock);
-	list_init (&ready_list);
 	list_init(&block_list);
 	list_init (&destruction_req);
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread ();
 	init_thread (initial_thread, "main", PRI_DEFAULT);
+	initial_thread->cpu = &boot_cpu;
 	initial_thread->status = THREAD_RUNNING;
 	initial_thread->tid = allocate_tid ();
 }
@@ -145,19 +141,20 @@ thread_start (void) {
 void
 thread_tick (void) {
 	struct thread *t = thread_current ();
+	struct cpu *c = t->cpu;
 
 	/* Update statistics. */
-	if (t == idle_thread)
-		idle_ticks++;
+	if (t == c->idle_thread)
+		c->idle_ticks++;
 #ifdef USERPROG
 	else if (t->pml4 != NULL)
-		user_ticks++;
+		c->user_ticks++;
 #endif
 	else
-		kernel_ticks++;
+		c->kernel_ticks++;
 
 	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+	if (++c->thread_ticks >= TIME_SLICE)
 		intr_yield_on_return ();
 }
 
@@ -165,7 +162,14 @@ thread_tick (void) {
 void
 thread_print_stats (void) {
 	printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
-			idle_ticks, kernel_ticks, user_ticks);
+			boot_cpu.idle_ticks, boot_cpu.kernel_ticks, boot_cpu.user_ticks);
+}
+
+/* Returns the CPU this code is running on.  Safe to call from
+   schedule(), unlike thread_current(). */
+struct cpu *
+this_cpu (void) {
+	return running_thread ()->cpu;
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -187,6 +191,7 @@ tid_t
 thread_create (const char *name, int priority,
 		thread_func *function, void *aux) {
 	struct thread *t;
+	struct switch_frame *sf;
 	tid_t tid;
 
 	ASSERT (function != NULL);
@@ -199,17 +204,20 @@ thread_create (const char *name, int priority,
 	/* Initialize thread. */
 	init_thread (t, name, priority);
 	tid = t->tid = allocate_tid ();
+	t->cpu = this_cpu ();
 	// printf("만들어진 thread의 tid = %d\n", tid);
-	/* Call the kernel_thread if it scheduled.
-	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
-	t->tf.rip = (uintptr_t) kernel_thread;
-	t->tf.R.rdi = (uint64_t) function;
-	t->tf.R.rsi = (uint64_t) aux;
-	t->tf.ds = SEL_KDSEG;
-	t->tf.es = SEL_KDSEG;
-	t->tf.ss = SEL_KDSEG;
-	t->tf.cs = SEL_KCSEG;
-	t->tf.eflags = FLAG_IF;
+	/* Call the kernel_thread if it scheduled: the first switch into
+	 * T returns into switch_entry(), which calls
+	 * kernel_thread (FUNCTION, AUX).  The slot above the frame
+	 * stands in for kernel_thread()'s return address. */
+	sf = (struct switch_frame *) ((uint8_t *) t + PGSIZE - sizeof (void *)) - 1;
+	*sf = (struct switch_frame) {
+		.rbx = (uint64_t) kernel_thread,
+		.r12 = (uint64_t) function,
+		.r13 = (uint64_t) aux,
+		.rip = switch_entry,
+	};
+	t->switch_rsp = (uint64_t) sf;
 
 	t->parent_t = thread_current();
 	sema_init(&t->fork_sema, 0); 
@@ -218,12 +226,10 @@ thread_create (const char *name, int priority,
 
 	list_push_back(&thread_current()->child_list, &t->child_elem);
 
-	t->fd_table = palloc_get_page(PAL_ZERO);
-	if(t->fd_table == NULL){
+	if (!fdt_init(t)) {
 		return TID_ERROR;
 	}
 
-	t->fd_idx = 2;
 	/* Add to run queue. */
 	thread_unblock (t);
 
@@ -264,9 +270,12 @@ void thread_unblock(struct thread *t)
 
 	old_level = intr_disable();
 	ASSERT(t->status == THREAD_BLOCKED);
-	list_insert_ordered(&ready_list, &t->elem, compare_reverse, NULL);
+	spin_lock(&t->cpu->rq_lock);
+	list_insert_ordered(&t->cpu->ready_list, &t->elem, compare_reverse, NULL);
+	t->cpu->ready_cnt++;
 
 	t->status = THREAD_READY;
+	spin_unlock(&t->cpu->rq_lock);
 
 	intr_set_level(old_level);
 }
@@ -328,9 +337,12 @@ void thread_yield(void)
 	ASSERT(!intr_context());
 
 	old_level = intr_disable();
-	if (curr != idle_thread)
+	if (curr != curr->cpu->idle_thread)
 	{
-		list_insert_ordered(&ready_list, &thread_current()->elem, compare_reverse, NULL);
+		spin_lock(&curr->cpu->rq_lock);
+		list_insert_ordered(&curr->cpu->ready_list, &curr->elem, compare_reverse, NULL);
+		curr->cpu->ready_cnt++;
+		spin_unlock(&curr->cpu->rq_lock);
 		do_schedule(THREAD_READY);
 	}
 	intr_set_level(old_level);
@@ -342,27 +354,62 @@ void thread_set_priority(int new_priority)
 	struct thread *curr = thread_current();
 
 	curr->priority_origin = new_priority;
+	thread_refresh_priority();
 
-	curr->priority = curr->priority_origin;
+	thread_yield();
+}
 
-	struct thread *front_thread = NULL;
+/* Recomputes the current thread's priority from its base priority,
+   the threads waiting on locks it holds, and the writers draining
+   rwlocks it reads. */
+void thread_refresh_priority(void)
+{
+	struct thread *curr = thread_current();
+	enum intr_level old_level;
+	struct list_elem *e;
 
-	if (!list_empty(&curr->donations))
+	old_level = intr_disable();
+	curr->priority = curr->priority_origin;
+	for (e = list_begin(&curr->donations); e != list_end(&curr->donations); e = list_next(e))
+	{
+		struct thread *donor = list_entry(e, struct thread, donation_elem);
+		if (donor->priority > curr->priority)
+			curr->priority = donor->priority;
+	}
+	for (e = list_begin(&curr->rw_donations); e != list_end(&curr->rw_donations); e = list_next(e))
 	{
-		front_thread = list_entry(list_begin(&curr->donations),
-								  struct thread,
-								  donation_elem);
+		struct rwlock_holder *h = list_entry(e, struct rwlock_holder, elem);
+		if (h->donation > curr->priority)
+			curr->priority = h->donation;
+	}
+	intr_set_level(old_level);
+}
+
 
-		if (curr->priority < front_thread->priority)
+/* Raises T's priority to PRIORITY on behalf of a thread waiting
+   for it, moving T up its run queue if it is ready to run.  Does
+   nothing if T already runs at PRIORITY or higher. */
+void thread_raise_priority(struct thread *t, int priority)
+{
+	enum intr_level old_level;
+
+	ASSERT(is_thread(t));
+
+	old_level = intr_disable();
+	if (t->priority < priority)
+	{
+		t->priority = priority;
+		if (t->status == THREAD_READY)
 		{
-			curr->priority = front_thread->priority;
+			spin_lock(&t->cpu->rq_lock);
+			list_remove(&t->elem);
+			list_insert_ordered(&t->cpu->ready_list, &t->elem, compare_reverse, NULL);
+			spin_unlock(&t->cpu->rq_lock);
 		}
 	}
-
-	thread_yield();
+	intr_set_level(old_level);
 }
 
-
 /* Returns the current thread's priority. */
 int
 thread_get_priority (void) {
@@ -400,7 +447,7 @@ thread_get_recent_cpu (void) {
 
    The idle thread is initially put on the ready list by
    thread_start().  It will be scheduled once initially, at which
-   point it initializes idle_thread, "up"s the semaphore passed
+   point it sets its CPU's idle_thread, "up"s the semaphore passed
    to it to enable thread_start() to continue, and immediately
    blocks.  After that, the idle thread never appears in the
    ready list.  It is returned by next_thread_to_run() as a
@@ -409,7 +456,7 @@ static void
 idle (void *idle_started_ UNUSED) {
 	struct semaphore *idle_started = idle_started_;
 
-	idle_thread = thread_current ();
+	this_cpu ()->idle_thread = thread_current ();
 	sema_up (idle_started);
 
 	for (;;) {
@@ -417,6 +464,15 @@ idle (void *idle_started_ UNUSED) {
 		intr_disable ();
 		thread_block ();
 
+		/* Nothing else wants the CPU: zero user pages ahead of
+		   PAL_ZERO requests until a thread becomes ready. */
+		intr_enable ();
+		while (this_cpu ()->ready_cnt == 0 && palloc_prezero ())
+			continue;
+		intr_disable ();
+		if (this_cpu ()->ready_cnt > 0)
+			continue;
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -456,13 +512,13 @@ init_thread(struct thread *t, const char *name, int priority)
 	memset(t, 0, sizeof *t);
 	t->status = THREAD_BLOCKED;
 	strlcpy(t->name, name, sizeof t->name);
-	t->tf.rsp = (uint64_t)t + PGSIZE - sizeof(void *);
 	t->priority = priority;
 	t->priority_origin = priority;
 	t->wait_on_lock = NULL;
 
 
 	list_init(&t->donations);
+	list_init(&t->rw_donations);
 	list_init(&t->child_list);
 
 
@@ -482,13 +538,19 @@ init_thread(struct thread *t, const char *name, int priority)
    return a thread from the run queue, unless the run queue is
    empty.  (If the running thread can continue running, then it
    will be in the run queue.)  If the run queue is empty, return
-   idle_thread. */
+   the CPU's idle_thread. */
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list))
-		return idle_thread;
-	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+	struct cpu *c = this_cpu ();
+	struct thread *next = c->idle_thread;
+
+	spin_lock (&c->rq_lock);
+	if (!list_empty (&c->ready_list)) {
+		next = list_entry (list_pop_front (&c->ready_list), struct thread, elem);
+		c->ready_cnt--;
+	}
+	spin_unlock (&c->rq_lock);
+	return next;
 }
 
 /* Use iretq to launch the thread */
@@ -519,73 +581,17 @@ do_iret (struct intr_frame *tf) {
 			: : "g" ((uint64_t) tf) : "memory");
 }
 
-/* Switching the thread by activating the new thread's page
-   tables, and, if the previous thread is dying, destroying it.
-
-   At this function's invocation, we just switched from thread
-   PREV, the new thread is already running, and interrupts are
-   still disabled.
+/* Switches from the running thread to TH.  Returns when the
+   running thread is switched back to.
 
-   It's not safe to call printf() until the thread switch is
-   complete.  In practice that means that printf()s should be
-   added at the end of the function. */
+   Interrupts must be off.  Only the callee-saved registers are
+   kept across the switch; see threads/switch.S.  The iretq path,
+   do_iret(), is left for entering user mode, where a full
+   interrupt frame is really needed. */
 static void
 thread_launch (struct thread *th) {
-	uint64_t tf_cur = (uint64_t) &running_thread ()->tf;
-	uint64_t tf = (uint64_t) &th->tf;
 	ASSERT (intr_get_level () == INTR_OFF);
-
-	/* The main switching logic.
-	 * We first restore the whole execution context into the intr_frame
-	 * and then switching to the next thread by calling do_iret.
-	 * Note that, we SHOULD NOT use any stack from here
-	 * until switching is done. */
-	__asm __volatile (
-			/* Store registers that will be used. */
-			"push %%rax\n"
-			"push %%rbx\n"
-			"push %%rcx\n"
-			/* Fetch input once */
-			"movq %0, %%rax\n"
-			"movq %1, %%rcx\n"
-			"movq %%r15, 0(%%rax)\n"
-			"movq %%r14, 8(%%rax)\n"
-			"movq %%r13, 16(%%rax)\n"
-			"movq %%r12, 24(%%rax)\n"
-			"movq %%r11, 32(%%rax)\n"
-			"movq %%r10, 40(%%rax)\n"
-			"movq %%r9, 48(%%rax)\n"
-			"movq %%r8, 56(%%rax)\n"
-			"movq %%rsi, 64(%%rax)\n"
-			"movq %%rdi, 72(%%rax)\n"
-			"movq %%rbp, 80(%%rax)\n"
-			"movq %%rdx, 88(%%rax)\n"
-			"pop %%rbx\n"              // Saved rcx
-			"movq %%rbx, 96(%%rax)\n"
-			"pop %%rbx\n"              // Saved rbx
-			"movq %%rbx, 104(%%rax)\n"
-			"pop %%rbx\n"              // Saved rax
-			"movq %%rbx, 112(%%rax)\n"
-			"addq $120, %%rax\n"
-			"movw %%es, (%%rax)\n"
-			"movw %%ds, 8(%%rax)\n"
-			"addq $32, %%rax\n"
-			"call __next\n"         // read the current rip.
-			"__next:\n"
-			"pop %%rbx\n"
-			"addq $(out_iret -  __next), %%rbx\n"
-			"movq %%rbx, 0(%%rax)\n" // rip
-			"movw %%cs, 8(%%rax)\n"  // cs
-			"pushfq\n"
-			"popq %%rbx\n"
-			"mov %%rbx, 16(%%rax)\n" // eflags
-			"mov %%rsp, 24(%%rax)\n" // rsp
-			"movw %%ss, 32(%%rax)\n"
-			"mov %%rcx, %%rdi\n"
-			"call do_iret\n"
-			"out_iret:\n"
-			: : "g"(tf_cur), "g" (tf) : "memory"
-			);
+	switch_threads (&running_thread ()->switch_rsp, th->switch_rsp);
 }
 
 /* Schedules a new process. At entry, interrupts must be off.
@@ -617,7 +623,8 @@ schedule (void) {
 	next->status = THREAD_RUNNING;
 
 	/* Start new time slice. */
-	thread_ticks = 0;
+	next->cpu = curr->cpu;
+	next->cpu->thread_ticks = 0;
 
 #ifdef USERPROG
 	/* Activate the new address space. */
@@ -637,6 +644,8 @@ schedule (void) {
 			list_push_back (&destruction_req, &curr->elem);
 		}
 
+		trace_event (TRACE_SCHEDULE, next->tid, curr->status);
+
 		/* Before switching the thread, we first save the information
 		 * of current running. */
 		thread_launch (next);
@@ -682,7 +691,7 @@ void insert_blockList(int64_t endtick)
 
 	curr->endTick = endtick;
 	old_level = intr_disable();
-	if (curr != idle_thread)
+	if (curr != curr->cpu->idle_thread)
 	{
 
 		list_insert_ordered(&block_list, &(curr->elem), compare_tick, NULL);
@@ -714,8 +723,13 @@ bool compare_reverse(const struct list_elem *a, const struct list_elem *b, void
 
 
 int next_thread_priority() {
-    if (list_empty(&ready_list))
-        return 0;
-    struct thread* max_t = list_max(&ready_list, compare, NULL);
-    return max_t->priority;
+    struct cpu *c = this_cpu();
+    int priority = 0;
+
+    spin_lock(&c->rq_lock);
+    if (!list_empty(&c->ready_list))
+        priority = list_entry(list_max(&c->ready_list, compare, NULL),
+                              struct thread, elem)->priority;
+    spin_unlock(&c->rq_lock);
+    return priority;
 }
\ No newline at end of file
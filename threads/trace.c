@@ -0,0 +1,119 @@
+#include "threads/trace.h"
+#include <debug.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+#ifdef FILESYS
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#endif
+
+/* Kernel trace ring.
+   Every tracepoint claims the next slot with one atomic add and
+   fills it in, so logging costs a few dozen cycles and needs no
+   lock, and the ring always holds the latest TRACE_CNT events.
+   A record being filled in while the ring is read may come out
+   torn, so trace_dump() stops logging first. */
+#define TRACE_PAGES 64
+#define TRACE_CNT (TRACE_PAGES * PGSIZE / sizeof (struct trace_record))
+
+static struct trace_record *trace_buf;  /* TRACE_CNT records. */
+static uint64_t trace_next;             /* Total records claimed. */
+static bool trace_enabled;
+
+/* Time stamp counter and timer ticks when tracing started, used
+   to estimate the counter's rate. */
+static uint64_t start_tsc;
+static int64_t start_ticks;
+
+/* Same as in thread.c: thread_current() asserts that the thread
+   is running, which it is not in the middle of schedule(). */
+#define running_thread() ((struct thread *) (pg_round_down (rrsp ())))
+
+/* Allocates the trace ring and starts logging. */
+void
+trace_init (void) {
+	trace_buf = palloc_get_multiple (PAL_ASSERT | PAL_ZERO, TRACE_PAGES);
+	start_tsc = rdtsc ();
+	start_ticks = timer_ticks ();
+	trace_enabled = true;
+}
+
+/* Logs EVENT with its two arguments. */
+void
+trace_event (enum trace_event event, uint64_t arg0, uint64_t arg1) {
+	struct thread *t;
+	struct trace_record *r;
+
+	if (!trace_enabled)
+		return;
+
+	t = running_thread ();
+	r = &trace_buf[__atomic_fetch_add (&trace_next, 1, __ATOMIC_RELAXED)
+		% TRACE_CNT];
+	r->tsc = rdtsc ();
+	r->event = event;
+	r->cpu = t->cpu != NULL ? t->cpu->id : 0;
+	r->tid = t->tid;
+	r->arg0 = arg0;
+	r->arg1 = arg1;
+}
+
+#ifdef FILESYS
+/* Writes the trace ring to file ARGV[1], for `pintos -g' to
+   copy out and utils/pintos-trace to decode. */
+void
+trace_dump (char **argv) {
+	const char *file_name = argv[1];
+	struct trace_header h;
+	struct file *file;
+	uint64_t first, cnt, ticks;
+	size_t start, n;
+
+	printf ("Dumping kernel trace to '%s'...\n", file_name);
+	ASSERT (trace_buf != NULL);
+
+	/* Stop logging, so that no record is torn, and so the writes
+	   below do not push out what we came to save. */
+	trace_enabled = false;
+	barrier ();
+
+	cnt = trace_next < TRACE_CNT ? trace_next : TRACE_CNT;
+	first = trace_next - cnt;
+	ticks = timer_elapsed (start_ticks);
+
+	h.magic = TRACE_MAGIC;
+	h.version = 1;
+	h.record_size = sizeof (struct trace_record);
+	h.record_cnt = cnt;
+	h.reserved = 0;
+	h.tsc_hz = ticks > 0 ? (rdtsc () - start_tsc) / ticks * TIMER_FREQ : 0;
+	h.lost_cnt = first;
+
+	if (!filesys_create (file_name, sizeof h + cnt * sizeof *trace_buf))
+		PANIC ("%s: create failed", file_name);
+	file = filesys_open (file_name);
+	if (file == NULL)
+		PANIC ("%s: open failed", file_name);
+
+	/* The oldest record is at FIRST % TRACE_CNT; if the ring has
+	   wrapped, the rest follow from the start of the buffer. */
+	start = first % TRACE_CNT;
+	n = cnt < TRACE_CNT - start ? cnt : TRACE_CNT - start;
+	if (file_write (file, &h, sizeof h) != sizeof h
+			|| file_write (file, trace_buf + start, n * sizeof *trace_buf)
+			!= (off_t) (n * sizeof *trace_buf)
+			|| file_write (file, trace_buf, (cnt - n) * sizeof *trace_buf)
+			!= (off_t) ((cnt - n) * sizeof *trace_buf))
+		PANIC ("%s: write failed", file_name);
+	file_close (file);
+
+	printf ("%llu events dumped, %llu lost.\n", cnt, first);
+	trace_enabled = true;
+}
+#endif
@@ -7,6 +7,7 @@
 #include "intrinsic.h"
 
 #include "userprog/syscall.h" //안되면 지울것
+#include "userprog/uaccess.h"
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -150,6 +151,11 @@ page_fault (struct intr_frame *f) {
 		return;
 #endif
 
+	/* A kernel access to user memory that could not be resolved
+	   above: let the accessor that made it report the failure. */
+	if (!user && uaccess_fixup (f))
+		return;
+
 	/* Count page faults. */
 	page_fault_cnt++;
 
@@ -0,0 +1,233 @@
+#include "userprog/exec-cache.h"
+#include <debug.h>
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#ifdef VM
+#include "vm/vm.h"
+#endif
+
+/* Images nobody is running stay cached, most recently used first,
+ * until there are more than this many. */
+#define EXEC_CACHE_MAX 8
+
+static struct list exec_cache;
+static size_t exec_cache_cnt;
+static struct lock exec_cache_lock;
+
+static void exec_cache_drop (struct exec_image *image);
+static void free_text_frames (struct exec_image *image);
+static void exec_image_destroy (struct exec_image *image);
+
+void
+exec_cache_init (void) {
+	list_init (&exec_cache);
+	lock_init (&exec_cache_lock);
+}
+
+/* Returns true if IMAGE no longer matches the file it was parsed
+ * from, or that file is on its way out. */
+static bool
+is_stale (const struct exec_image *image) {
+	struct inode *inode = file_get_inode (image->file);
+	return inode_is_removed (inode)
+		|| inode_write_count (inode) != image->write_cnt;
+}
+
+/* Returns the cached image of FILE, with a reference taken for
+ * the caller, or NULL if FILE must be parsed. */
+struct exec_image *
+exec_cache_get (struct file *file) {
+	struct inode *inode = file_get_inode (file);
+	struct exec_image *found = NULL;
+	struct list_elem *e;
+
+	lock_acquire (&exec_cache_lock);
+	for (e = list_begin (&exec_cache); e != list_end (&exec_cache);
+			e = list_next (e)) {
+		struct exec_image *image = list_entry (e, struct exec_image, elem);
+		if (file_get_inode (image->file) == inode) {
+			if (is_stale (image))
+				exec_cache_drop (image);
+			else {
+				found = image;
+				found->users++;
+				list_remove (&found->elem);
+				list_push_front (&exec_cache, &found->elem);
+			}
+			break;
+		}
+	}
+	lock_release (&exec_cache_lock);
+	return found;
+}
+
+/* Caches IMAGE, fresh from exec_image_create(), and returns it with
+ * a reference taken for the caller.  If another process cached the
+ * same file first, IMAGE is discarded and theirs is returned. */
+struct exec_image *
+exec_cache_add (struct exec_image *image) {
+	struct exec_image *existing = exec_cache_get (image->file);
+	struct list_elem *e;
+
+	if (existing != NULL) {
+		exec_image_discard (image);
+		return existing;
+	}
+
+	lock_acquire (&exec_cache_lock);
+	image->cached = true;
+	image->users = 1;
+	list_push_front (&exec_cache, &image->elem);
+	exec_cache_cnt++;
+
+	/* Trim idle images from the cold end. */
+	e = list_rbegin (&exec_cache);
+	while (exec_cache_cnt > EXEC_CACHE_MAX && e != list_rend (&exec_cache)) {
+		struct exec_image *victim = list_entry (e, struct exec_image, elem);
+		e = list_prev (e);
+		if (victim->users == 0)
+			exec_cache_drop (victim);
+	}
+	lock_release (&exec_cache_lock);
+	return image;
+}
+
+/* Takes IMAGE out of the cache.  Processes still running it keep
+ * it alive until the last one calls exec_image_release(). */
+static void
+exec_cache_drop (struct exec_image *image) {
+	ASSERT (lock_held_by_current_thread (&exec_cache_lock));
+	ASSERT (image->cached);
+
+	list_remove (&image->elem);
+	exec_cache_cnt--;
+	image->cached = false;
+	if (image->users == 0)
+		exec_image_destroy (image);
+}
+
+/* Returns a new, uncached image of FILE with room for MAX_SEGS
+ * segments, or NULL if out of memory. */
+struct exec_image *
+exec_image_create (struct file *file, uint64_t entry, int max_segs) {
+	struct exec_image *image;
+
+	image = malloc (sizeof *image + max_segs * sizeof *image->segs);
+	if (image == NULL)
+		return NULL;
+	image->file = file_reopen (file);
+	if (image->file == NULL) {
+		free (image);
+		return NULL;
+	}
+	image->write_cnt = inode_write_count (file_get_inode (file));
+	image->cached = false;
+	image->users = 0;
+	image->entry = entry;
+	image->seg_cnt = 0;
+	return image;
+}
+
+/* Appends a segment to IMAGE, which must have room for it.
+ * Read-only segments get one shared text frame per page. */
+bool
+exec_image_add_segment (struct exec_image *image, off_t file_page,
+		uint8_t *mem_page, uint32_t read_bytes, uint32_t zero_bytes,
+		bool writable) {
+	struct exec_segment *seg = &image->segs[image->seg_cnt];
+
+	*seg = (struct exec_segment) {
+		.file_page = file_page,
+		.mem_page = mem_page,
+		.read_bytes = read_bytes,
+		.zero_bytes = zero_bytes,
+		.writable = writable,
+		.text = NULL,
+	};
+#ifdef VM
+	if (!writable) {
+		size_t page_cnt = (read_bytes + zero_bytes) / PGSIZE;
+		size_t i;
+
+		seg->text = calloc (page_cnt, sizeof *seg->text);
+		if (seg->text == NULL)
+			return false;
+		for (i = 0; i < page_cnt; i++) {
+			struct text_frame *text = &seg->text[i];
+			text->file = image->file;
+			text->ofs = file_page + i * PGSIZE;
+			text->read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
+			read_bytes -= text->read_bytes;
+		}
+	}
+#endif
+	image->seg_cnt++;
+	return true;
+}
+
+/* Frees IMAGE, which never made it into the cache. */
+void
+exec_image_discard (struct exec_image *image) {
+	ASSERT (!image->cached);
+	exec_image_destroy (image);
+}
+
+/* Takes another reference to IMAGE, which the caller already
+ * holds one to. */
+struct exec_image *
+exec_image_ref (struct exec_image *image) {
+	lock_acquire (&exec_cache_lock);
+	ASSERT (image->users > 0);
+	image->users++;
+	lock_release (&exec_cache_lock);
+	return image;
+}
+
+/* Gives up a reference to IMAGE.  Once nobody runs it, its text
+ * frames go back to the pool; a cached image keeps only its
+ * parsed headers. */
+void
+exec_image_release (struct exec_image *image) {
+	lock_acquire (&exec_cache_lock);
+	ASSERT (image->users > 0);
+	if (--image->users == 0) {
+		if (image->cached)
+			free_text_frames (image);
+		else
+			exec_image_destroy (image);
+	}
+	lock_release (&exec_cache_lock);
+}
+
+/* Frees whatever text frames of IMAGE have been read in. */
+static void
+free_text_frames (struct exec_image *image) {
+#ifdef VM
+	int i;
+
+	for (i = 0; i < image->seg_cnt; i++) {
+		struct exec_segment *seg = &image->segs[i];
+		size_t page_cnt = (seg->read_bytes + seg->zero_bytes) / PGSIZE;
+		size_t j;
+
+		if (seg->text != NULL)
+			for (j = 0; j < page_cnt; j++)
+				text_frame_free (&seg->text[j]);
+	}
+#endif
+}
+
+/* Frees IMAGE and everything it owns. */
+static void
+exec_image_destroy (struct exec_image *image) {
+	int i;
+
+	ASSERT (image->users == 0);
+	free_text_frames (image);
+	for (i = 0; i < image->seg_cnt; i++)
+		free (image->segs[i].text);
+	file_close (image->file);
+	free (image);
+}
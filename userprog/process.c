@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <spawn.h>
 #include "userprog/gdt.h"
 #include "userprog/tss.h"
 #include "filesys/directory.h"
@@ -20,6 +21,7 @@
 #include "threads/synch.h"
 #include "intrinsic.h"
 #include "userprog/syscall.h"
+#include "userprog/exec-cache.h"
 
 #define VM
 
@@ -31,6 +33,8 @@ static void process_cleanup(void);
 static bool load(const char *file_name, struct intr_frame *if_);
 static void initd(void *f_name);
 static void __do_fork(void *);
+static void __do_vfork(void *);
+static void spawnd(void *);
 void args_to_stack(char **argv_list, int count, char **rsp);
 
 struct semaphore exec_sema;
@@ -148,7 +152,7 @@ duplicate_pte(uint64_t *pte, void *va, void *aux)
 	/* 4. TODO: Duplicate parent's page to the new page and
 	 *    TODO: check whether parent's page is writable or not (set WRITABLE
 	 *    TODO: according to the result). */
-	memcpy(newpage, parent_page, PGSIZE);
+	page_copy(newpage, parent_page);
 	writable = is_writable(pte); // *PTE is an address that points to parent_page
 
 	/* 5. Add new page to child's page table at address VA with WRITABLE
@@ -199,21 +203,10 @@ __do_fork(void *aux)
 	 * TODO:       from the fork() until this function successfully duplicates
 	 * TODO:       the resources of parent.*/
 
-	int cnt = 2;
-	struct file **table = parent->fd_table;
-	while (cnt < 128)
-	{
-		if (table[cnt])
-		{
-			current->fd_table[cnt] = file_duplicate(table[cnt]);
-		}
-		else
-		{
-			current->fd_table[cnt] = NULL;
-		}
-		cnt++;
-	}
-	current->fd_idx = parent->fd_idx;
+	if (!fdt_duplicate(current, parent))
+		goto error;
+	if (parent->exec_image != NULL)
+		current->exec_image = exec_image_ref(parent->exec_image);
 
 	sema_up(&parent->fork_sema);
 	process_init();
@@ -226,6 +219,175 @@ error:
 	exit(TID_ERROR);
 }
 
+/* Handed to __do_vfork() on the parent's stack. */
+struct vfork_aux
+{
+	struct thread *parent;
+	bool success;
+};
+
+/* Clones the current process as `name`, but lends it this process's
+ * page table and SPT instead of copying them.  Blocks until the
+ * child calls exec() or exit() and process_cleanup() gives them
+ * back.  Returns the new process's thread id, or TID_ERROR. */
+tid_t process_vfork(const char *name)
+{
+	struct thread *cur = thread_current();
+	struct vfork_aux aux = {cur, false};
+
+	tid_t tid = thread_create(name, PRI_DEFAULT, __do_vfork, &aux);
+	if (tid == TID_ERROR)
+	{
+		return TID_ERROR;
+	}
+
+	sema_down(&cur->fork_sema);
+	if (!aux.success)
+	{
+		process_wait(tid);
+		return TID_ERROR;
+	}
+	return tid;
+}
+
+/* A thread function that starts a vfork() child on the parent's
+ * address space. */
+static void
+__do_vfork(void *aux_)
+{
+	struct vfork_aux *aux = aux_;
+	struct thread *parent = aux->parent;
+	struct thread *current = thread_current();
+	struct intr_frame if_;
+
+	memcpy(&if_, &parent->ptf, sizeof(struct intr_frame));
+	if_.R.rax = 0;
+
+	/* The descriptor table is still copied, so close() in the child
+	 * leaves the parent's files alone. */
+	if (!fdt_duplicate(current, parent))
+	{
+#ifdef VM
+		supplemental_page_table_init(&current->spt);
+#endif
+		sema_up(&parent->fork_sema);
+		exit(TID_ERROR);
+	}
+
+	/* The parent sleeps until we give these back, so nobody else
+	 * touches them meanwhile. */
+	current->pml4 = parent->pml4;
+#ifdef VM
+	current->spt = parent->spt;
+	current->stack_bottom = parent->stack_bottom;
+#endif
+	current->vfork_parent = parent;
+	aux->success = true;
+
+	process_init();
+	process_activate(current);
+	do_iret(&if_);
+	NOT_REACHED();
+}
+
+/* Everything spawnd() needs from the parent.  Lives on the
+ * parent's stack, which stays put until spawnd() signals
+ * fork_sema. */
+struct spawn_aux
+{
+	struct thread *parent;
+	char *cmd_line;
+	const struct spawn_fd *fds;
+	int fd_cnt;
+	bool success;
+};
+
+/* Starts CMD_LINE as a new child process, without copying the
+ * current address space the way fork() + exec() would.  The child
+ * starts with the console as fds 0 and 1 and then applies FDS in
+ * order.  Takes ownership of CMD_LINE, a page from palloc.  Returns
+ * the child's thread id, or TID_ERROR if it could not be loaded. */
+tid_t process_spawn(char *cmd_line, const struct spawn_fd *fds, int fd_cnt)
+{
+	struct thread *cur = thread_current();
+	struct spawn_aux aux = {cur, cmd_line, fds, fd_cnt, false};
+	char name[sizeof cur->name];
+	size_t len = strcspn(cmd_line, " ");
+
+	strlcpy(name, cmd_line, len + 1 < sizeof name ? len + 1 : sizeof name);
+
+	tid_t tid = thread_create(name, PRI_DEFAULT, spawnd, &aux);
+	if (tid == TID_ERROR)
+	{
+		palloc_free_page(cmd_line);
+		return TID_ERROR;
+	}
+
+	sema_down(&cur->fork_sema);
+	if (!aux.success)
+	{
+		/* Reap it now; the caller never learns its pid. */
+		process_wait(tid);
+		return TID_ERROR;
+	}
+	return tid;
+}
+
+/* A thread function that builds a spawned process straight from
+ * its executable. */
+static void
+spawnd(void *aux_)
+{
+	struct spawn_aux *aux = aux_;
+	struct thread *parent = aux->parent;
+	struct thread *current = thread_current();
+	struct intr_frame _if;
+	int i;
+
+	supplemental_page_table_init(&current->spt);
+	process_init();
+
+	/* The parent is blocked, so its table cannot change under us. */
+	for (i = 0; i < aux->fd_cnt; i++)
+	{
+		const struct spawn_fd *action = &aux->fds[i];
+		struct file *file = NULL;
+
+		if (action->parent_fd >= 0)
+		{
+			file = parent->fd_table[action->parent_fd];
+			if (file != NULL && !is_console_file(file))
+				file = file_duplicate(file);
+			if (file == NULL)
+				goto done;
+		}
+		if (!fdt_install(current, action->child_fd, file))
+		{
+			if (file != NULL && !is_console_file(file))
+				file_close(file);
+			goto done;
+		}
+	}
+
+	_if.ds = _if.es = _if.ss = SEL_UDSEG;
+	_if.cs = SEL_UCSEG;
+	_if.eflags = FLAG_IF | FLAG_MBS;
+	aux->success = load(aux->cmd_line, &_if);
+
+done:
+	palloc_free_page(aux->cmd_line);
+	if (!aux->success)
+	{
+		sema_up(&parent->fork_sema);
+		exit(TID_ERROR);
+	}
+
+	/* AUX is gone once the parent wakes up. */
+	sema_up(&parent->fork_sema);
+	do_iret(&_if);
+	NOT_REACHED();
+}
+
 /* Switch the current execution context to the f_name.
  * Returns -1 on fail. */
 int process_exec(void *f_name)
@@ -315,7 +477,6 @@ int process_wait(tid_t child_tid)
 void process_exit(void)
 {
 	struct thread *curr = thread_current();
-	struct file **table = curr->fd_table;
 
 	/* TODO: Your code goes here.
 	 * TODO: Implement process termination message (see
@@ -327,22 +488,11 @@ void process_exit(void)
 		file_close(curr->file_cur);
 	}
 
-	int cnt = 2;
-	while (cnt < 128)
-	{
-		if (table[cnt])
-		{
-			file_close(table[cnt]);
-			table[cnt] = NULL;
-		}
-		cnt++;
-	}
+	fdt_destroy(curr);
 
 	process_cleanup();
 	sema_up(&curr->sema_wait);
 	sema_down(&curr->sema_exit);
-
-	palloc_free_page(table);
 }
 
 /* Free the current process's resources. */
@@ -351,6 +501,28 @@ process_cleanup(void)
 {
 	struct thread *curr = thread_current();
 
+	/* The rings live in the address space being torn down.  The
+	 * kernel holds no pins on them, so forgetting them is enough. */
+	curr->ring_sq = NULL;
+	curr->ring_cq = NULL;
+
+	/* A vfork() child only borrowed its address space: return it
+	 * rather than destroy it.  Stack growth may have changed the
+	 * SPT and the stack bottom, so the parent takes our copies. */
+	if (curr->vfork_parent != NULL)
+	{
+		struct thread *parent = curr->vfork_parent;
+#ifdef VM
+		parent->spt = curr->spt;
+		parent->stack_bottom = curr->stack_bottom;
+#endif
+		curr->vfork_parent = NULL;
+		curr->pml4 = NULL;
+		pml4_activate(NULL);
+		sema_up(&parent->fork_sema);
+		return;
+	}
+
 #ifdef VM
 	supplemental_page_table_kill(&curr->spt);
 #endif
@@ -372,14 +544,24 @@ process_cleanup(void)
 		pml4_activate(NULL);
 		pml4_destroy(pml4);
 	}
+
+	/* Only now is nothing left mapping the image's text. */
+	if (curr->exec_image != NULL)
+	{
+		exec_image_release(curr->exec_image);
+		curr->exec_image = NULL;
+	}
 }
 
 /* Sets up the CPU for running user code in the nest thread.
  * This function is called on every context switch. */
 void process_activate(struct thread *next)
 {
-	/* Activate thread's page tables. */
-	pml4_activate(next->pml4);
+	/* Activate thread's page tables.  A kernel thread only touches
+	 * kernel memory, which every page table maps the same way, so
+	 * it keeps running on whichever one is loaded. */
+	if (next->pml4 != NULL)
+		pml4_activate(next->pml4);
 
 	/* Set thread's kernel stack for use in processing interrupts. */
 	tss_update(next);
@@ -442,9 +624,13 @@ struct ELF64_PHDR
 
 static bool setup_stack(struct intr_frame *if_);
 static bool validate_segment(const struct Phdr *, struct file *);
+static struct exec_image *parse_executable(struct file *, const char *file_name);
 static bool load_segment(struct file *file, off_t ofs, uint8_t *upage,
 						 uint32_t read_bytes, uint32_t zero_bytes,
 						 bool writable);
+#ifdef VM
+static bool load_text_segment(const struct exec_segment *);
+#endif
 
 /* Loads an ELF executable from FILE_NAME into the current thread.
  * Stores the executable's entry point into *RIP
@@ -454,9 +640,8 @@ static bool
 load(const char *file_name, struct intr_frame *if_) // 1 또는 true를 뱉어야해..!!
 {
 	struct thread *t = thread_current();
-	struct ELF ehdr;
+	struct exec_image *image;
 	struct file *file = NULL;
-	off_t file_ofs;
 	bool success = false;
 	int i;
 
@@ -479,77 +664,38 @@ load(const char *file_name, struct intr_frame *if_) // 1 또는 true를 뱉어
 	/* Open executable file. */
 	// sema_down(&exec_sema);
 	file = filesys_open(file_name);
-	bool hello = true;
 	if (file == NULL)
 	{
 		printf("load: %s: open failed\n", file_name);
 		goto done;
 	}
+	if (t->file_cur != NULL)
+		file_close(t->file_cur);
+	t->file_cur = file;
+	file_deny_write(file);
 
-	/* Read and verify executable header. */
-	if (file_read(file, &ehdr, sizeof ehdr) != sizeof ehdr || memcmp(ehdr.e_ident, "\177ELF\2\1\1", 7) || ehdr.e_type != 2 || ehdr.e_machine != 0x3E // amd64
-		|| ehdr.e_version != 1 || ehdr.e_phentsize != sizeof(struct Phdr) || ehdr.e_phnum > 1024)
-	{
-		printf("load: %s: error loading executable\n", file_name);
+	/* Parse the headers, unless a cached parse is still good. */
+	image = exec_cache_get(file);
+	if (image == NULL)
+		image = parse_executable(file, file_name);
+	if (image == NULL)
 		goto done;
-	}
+	t->exec_image = image;
 
-	/* Read program headers. */
-	file_ofs = ehdr.e_phoff;
-	for (i = 0; i < ehdr.e_phnum; i++)
+	for (i = 0; i < image->seg_cnt; i++)
 	{
-		struct Phdr phdr;
-
-		if (file_ofs < 0 || file_ofs > file_length(file))
-			goto done;
-		file_seek(file, file_ofs);
-
-		if (file_read(file, &phdr, sizeof phdr) != sizeof phdr)
-			goto done;
-		file_ofs += sizeof phdr;
-		switch (phdr.p_type)
+		const struct exec_segment *seg = &image->segs[i];
+#ifdef VM
+		if (seg->text != NULL)
 		{
-		case PT_NULL:
-		case PT_NOTE:
-		case PT_PHDR:
-		case PT_STACK:
-		default:
-			/* Ignore this segment. */
-			break;
-		case PT_DYNAMIC:
-		case PT_INTERP:
-		case PT_SHLIB:
-			goto done;
-		case PT_LOAD:
-			if (validate_segment(&phdr, file))
-			{
-				bool writable = (phdr.p_flags & PF_W) != 0;
-				uint64_t file_page = phdr.p_offset & ~PGMASK;
-				uint64_t mem_page = phdr.p_vaddr & ~PGMASK;
-				uint64_t page_offset = phdr.p_vaddr & PGMASK;
-				uint32_t read_bytes, zero_bytes;
-				if (phdr.p_filesz > 0)
-				{
-					/* Normal segment.
-					 * Read initial part from disk and zero the rest. */
-					read_bytes = page_offset + phdr.p_filesz;
-					zero_bytes = (ROUND_UP(page_offset + phdr.p_memsz, PGSIZE) - read_bytes);
-				}
-				else
-				{
-					/* Entirely zero.
-					 * Don't read anything from disk. */
-					read_bytes = 0;
-					zero_bytes = ROUND_UP(page_offset + phdr.p_memsz, PGSIZE);
-				}
-				if (!load_segment(file, file_page, (void *)mem_page,
-								  read_bytes, zero_bytes, writable))
-					goto done;
-			}
-			else
+			if (!load_text_segment(seg))
 				goto done;
-			break;
+			continue;
 		}
+#endif
+		if (!load_segment(file, seg->file_page, seg->mem_page,
+						  seg->read_bytes, seg->zero_bytes, seg->writable))
+			goto done;
 	}
 
 	/* Set up stack. */
@@ -557,7 +703,7 @@ load(const char *file_name, struct intr_frame *if_) // 1 또는 true를 뱉어
 		goto done;
 
 	/* Start address. */
-	if_->rip = ehdr.e_entry;
+	if_->rip = image->entry;
 
 	/* TODO: Your code goes here.
 	 * TODO: Implement argument passing (see project2/argument_passing.html). */
@@ -596,14 +742,97 @@ load(const char *file_name, struct intr_frame *if_) // 1 또는 true를 뱉어
 	success = true;
 
 	// hex_dump(if_->rsp, if_->rsp, USER_STACK - if_->rsp, true);
-	t->file_cur = file;
-	file_deny_write(file);
 
 done:
 	/* We arrive here whether the load is successful or not. */
 	return success;
 }
 
+/* Reads and checks the ELF headers of FILE, opened as FILE_NAME,
+ * and caches the result.  Returns the image with a reference taken
+ * for the caller, or NULL if FILE is not a loadable executable. */
+static struct exec_image *
+parse_executable(struct file *file, const char *file_name)
+{
+	struct exec_image *image;
+	struct ELF ehdr;
+	off_t file_ofs;
+	int i;
+
+	/* Read and verify executable header. */
+	if (file_read_at(file, &ehdr, sizeof ehdr, 0) != sizeof ehdr || memcmp(ehdr.e_ident, "\177ELF\2\1\1", 7) || ehdr.e_type != 2 || ehdr.e_machine != 0x3E // amd64
+		|| ehdr.e_version != 1 || ehdr.e_phentsize != sizeof(struct Phdr) || ehdr.e_phnum > 1024)
+	{
+		printf("load: %s: error loading executable\n", file_name);
+		return NULL;
+	}
+
+	image = exec_image_create(file, ehdr.e_entry, ehdr.e_phnum);
+	if (image == NULL)
+		return NULL;
+
+	/* Read program headers. */
+	file_ofs = ehdr.e_phoff;
+	for (i = 0; i < ehdr.e_phnum; i++)
+	{
+		struct Phdr phdr;
+
+		if (file_ofs < 0 || file_ofs > file_length(file))
+			goto error;
+		if (file_read_at(file, &phdr, sizeof phdr, file_ofs) != sizeof phdr)
+			goto error;
+		file_ofs += sizeof phdr;
+		switch (phdr.p_type)
+		{
+		case PT_NULL:
+		case PT_NOTE:
+		case PT_PHDR:
+		case PT_STACK:
+		default:
+			/* Ignore this segment. */
+			break;
+		case PT_DYNAMIC:
+		case PT_INTERP:
+		case PT_SHLIB:
+			goto error;
+		case PT_LOAD:
+			if (validate_segment(&phdr, file))
+			{
+				bool writable = (phdr.p_flags & PF_W) != 0;
+				uint64_t file_page = phdr.p_offset & ~PGMASK;
+				uint64_t mem_page = phdr.p_vaddr & ~PGMASK;
+				uint64_t page_offset = phdr.p_vaddr & PGMASK;
+				uint32_t read_bytes, zero_bytes;
+				if (phdr.p_filesz > 0)
+				{
+					/* Normal segment.
+					 * Read initial part from disk and zero the rest. */
+					read_bytes = page_offset + phdr.p_filesz;
+					zero_bytes = (ROUND_UP(page_offset + phdr.p_memsz, PGSIZE) - read_bytes);
+				}
+				else
+				{
+					/* Entirely zero.
+					 * Don't read anything from disk. */
+					read_bytes = 0;
+					zero_bytes = ROUND_UP(page_offset + phdr.p_memsz, PGSIZE);
+				}
+				if (!exec_image_add_segment(image, file_page, (void *)mem_page,
+											read_bytes, zero_bytes, writable))
+					goto error;
+			}
+			else
+				goto error;
+			break;
+		}
+	}
+	return exec_cache_add(image);
+
+error:
+	exec_image_discard(image);
+	return NULL;
+}
+
 /* Checks whether PHDR describes a valid, loadable segment in
  * FILE and returns true if so, false otherwise. */
 static bool
@@ -829,6 +1058,16 @@ load_segment(struct file *file, off_t ofs, uint8_t *upage,
 		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
+		/* Pure BSS needs no loader: it starts out as the zero page. */
+		if (page_read_bytes == 0)
+		{
+			if (!vm_alloc_page(VM_ANON, upage, writable))
+				return false;
+			zero_bytes -= page_zero_bytes;
+			upage += PGSIZE;
+			continue;
+		}
+
 		/* TODO: Set up aux to pass information to the lazy_load_segment. */
 		struct page_info *page_info = (struct page_info *)malloc(sizeof(struct page_info));
 		page_info->file = file_reopen(file);
@@ -852,6 +1091,20 @@ load_segment(struct file *file, off_t ofs, uint8_t *upage,
 	return true;
 }
 
+/* Maps the read-only segment SEG onto its image's shared text
+ * frames.  Nothing is read until some process touches a page. */
+static bool
+load_text_segment(const struct exec_segment *seg)
+{
+	size_t page_cnt = (seg->read_bytes + seg->zero_bytes) / PGSIZE;
+	size_t i;
+
+	for (i = 0; i < page_cnt; i++)
+		if (!vm_alloc_text_page(seg->mem_page + i * PGSIZE, &seg->text[i]))
+			return false;
+	return true;
+}
+
 /* Create a PAGE of stack at the USER_STACK. Return true on success. */
 static bool
 setup_stack(struct intr_frame *if_)
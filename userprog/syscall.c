@@ -1,8 +1,10 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "threads/loader.h"
 #include "userprog/gdt.h"
 #include "threads/flags.h"
@@ -12,7 +14,14 @@
 #include "threads/palloc.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/directory.h"
+#include "userprog/uaccess.h"
 #include "threads/synch.h"
+#include "threads/malloc.h"
+#include <bitmap.h>
+#include <uio.h>
+#include <ring.h>
+#include <spawn.h>
 
 void syscall_entry(void);
 void syscall_handler(struct intr_frame *);
@@ -30,11 +39,8 @@ void syscall_handler(struct intr_frame *);
 #define MSR_LSTAR 0xc0000082		/* Long mode SYSCALL target */
 #define MSR_SYSCALL_MASK 0xc0000084 /* Mask for the eflags */
 
-struct semaphore syn_sema;
-
 void syscall_init(void)
 {
-	sema_init(&syn_sema, 1);
 	write_msr(MSR_STAR, ((uint64_t)SEL_UCSEG - 0x10) << 48 |
 							((uint64_t)SEL_KCSEG) << 32);
 	write_msr(MSR_LSTAR, (uint64_t)syscall_entry);
@@ -67,11 +73,21 @@ syscall_handler_t syscall_handlers[] = {
     [SYS_TELL] = call_tell,
     [SYS_MMAP] = call_mmap,
     [SYS_MUNMAP] = call_munmap,
+    [SYS_READV] = call_readv,
+    [SYS_WRITEV] = call_writev,
+    [SYS_PREAD] = call_pread,
+    [SYS_PWRITE] = call_pwrite,
+    [SYS_RING_SETUP] = call_ring_setup,
+    [SYS_RING_ENTER] = call_ring_enter,
+    [SYS_DUP2] = call_dup2,
+    [SYS_SPAWN] = call_spawn,
+    [SYS_VFORK] = call_vfork,
 };
 
 void syscall_handler(struct intr_frame *f) {
 	struct thread *curr = thread_current();
-	syscall_handler_t handler = syscall_handlers[f->R.rax];
+	uint64_t nr = f->R.rax;
+	syscall_handler_t handler = syscall_handlers[nr];
 
 	struct res_data res_data = {
 		.rdi = f->R.rdi,
@@ -85,7 +101,9 @@ void syscall_handler(struct intr_frame *f) {
 
 	
 	if (handler) {
+		trace_event(TRACE_SYSCALL_ENTER, f->R.rax, f->R.rdi);
 		f->R.rax = handler(res_data);
+		trace_event(TRACE_SYSCALL_EXIT, nr, f->R.rax);
 		// handler(res_data);
 		return;
 	}
@@ -116,41 +134,121 @@ void exit(uint64_t status)
 	return;
 }
 
-int call_write(struct res_data res_data)
+/* Copies the file name at user address UNAME into NAME.  Kills
+ * the process if UNAME is not readable; returns false if the name
+ * is too long to name any file. */
+static bool copy_in_name(char name[NAME_MAX + 1], const char *uname)
 {
+	long len = strncpy_from_user(name, uname, NAME_MAX + 1);
 
-	int fd = res_data.rdi;
-	const void *buffer = res_data.rsi;
-	unsigned size = res_data.rdx;
+	if (len < 0)
+	{
+		exit(-1);
+	}
+	return len <= NAME_MAX;
+}
 
-	sema_down(&syn_sema);
-	check_addr(buffer);
+/* Writes SIZE bytes at user address BUFFER to the console, a
+ * chunk at a time through a kernel buffer so that putbuf() never
+ * faults while it holds the console lock. */
+static void write_console(const char *buffer, unsigned size)
+{
+	char chunk[256];
 
-	if (fd == 1) // fd 0 : 표준입력, fd 1 : 표준 출력
+	while (size > 0)
 	{
-		putbuf(buffer, size);
-		sema_up(&syn_sema);
-		return size;
+		unsigned n = size < sizeof chunk ? size : sizeof chunk;
+		if (copy_from_user(chunk, buffer, n) != 0)
+		{
+			exit(-1);
+		}
+		putbuf(chunk, n);
+		buffer += n;
+		size -= n;
 	}
-	if (fd == 0)
+}
+
+/* Reads SIZE keystrokes into the user buffer BUFFER.  Kills the
+ * process on a bad address. */
+static void read_console(uint8_t *buffer, unsigned size)
+{
+	unsigned i;
+
+	for (i = 0; i < size; i++)
 	{
-		sema_up(&syn_sema);
-		return -1;
+		uint8_t key = input_getc();
+		if (copy_to_user(buffer + i, &key, 1) != 0)
+		{
+			exit(-1);
+		}
+	}
+}
+
+/* Most of a user buffer that one file transfer pins at a time.
+ * Larger transfers go through in pieces, so that a single call
+ * cannot pin down an unbounded share of user memory. */
+#define PIN_CHUNK (16 * PGSIZE)
+
+/* Moves SIZE bytes between the user buffer BUFFER and FILE at
+ * offset OFS, into the file if WRITE is true and out of it
+ * otherwise.  The buffer is pinned a chunk at a time so the disk
+ * can transfer sectors straight into or out of it.  Returns the
+ * number of bytes moved, which stops short at the first short
+ * transfer.  Kills the process on a bad address. */
+static off_t rw_pinned(struct file *file, void *buffer, off_t size, off_t ofs, bool write)
+{
+	off_t total = 0;
+
+	while (total < size)
+	{
+		uint8_t *chunk = (uint8_t *)buffer + total;
+		off_t len = PIN_CHUNK - pg_ofs(chunk);
+		off_t done;
+
+		if (len > size - total)
+			len = size - total;
+		if (!vm_pin_buffer(chunk, len, !write))
+		{
+			exit(-1);
+		}
+		done = write ? file_write_at(file, chunk, len, ofs + total)
+					 : file_read_at(file, chunk, len, ofs + total);
+		vm_unpin_buffer(chunk, len);
+		total += done;
+		if (done < len)
+			break;
 	}
+	return total;
+}
+
+int call_write(struct res_data res_data)
+{
+	int fd = res_data.rdi;
+	const void *buffer = res_data.rsi;
+	unsigned size = res_data.rdx;
+
 	struct file *file = find_file_by_Fd(fd);
 	if (file == NULL)
 	{
-		sema_up(&syn_sema);
 		exit(-1);
 	}
+	if (file == STDOUT_FILE) // 표준 출력, dup2()로 다른 fd에 붙어 있을 수도 있다
+	{
+		write_console(buffer, size);
+		return size;
+	}
+	if (file == STDIN_FILE)
+	{
+		return -1;
+	}
 
 	if (file->deny_write)
 	{
-		sema_up(&syn_sema);
 		return 0;
 	}
-	int write_byte = file_write(file, buffer, size);
-	sema_up(&syn_sema);
+	off_t pos = file_tell(file);
+	int write_byte = rw_pinned(file, (void *)buffer, size, pos, true);
+	file_seek(file, pos + write_byte);
 	return write_byte;
 }
 
@@ -158,13 +256,13 @@ bool call_create(struct res_data res_data)
 {
 	const char *file = res_data.rdi;
 	unsigned initial_size = res_data.rsi;
+	char name[NAME_MAX + 1];
 
-	sema_down(&syn_sema);
-	check_addr(file);
-	bool result = filesys_create(file, initial_size);
-	sema_up(&syn_sema);
-
-	return result;
+	if (!copy_in_name(name, file))
+	{
+		return false;
+	}
+	return filesys_create(name, initial_size);
 }
 
 void call_halt(struct res_data res_data)
@@ -175,14 +273,16 @@ void call_halt(struct res_data res_data)
 int call_open(struct res_data res_data)
 {
 	const char * file = res_data.rdi;
-	sema_down(&syn_sema);
-	check_addr(file);
+	char name[NAME_MAX + 1];
 
-	struct file *open_file = filesys_open(file);
+	if (!copy_in_name(name, file))
+	{
+		return -1;
+	}
+	struct file *open_file = filesys_open(name);
 
 	if (open_file == NULL)
 	{
-		sema_up(&syn_sema);
 		return -1;
 	}
 
@@ -193,7 +293,6 @@ int call_open(struct res_data res_data)
 		file_close(open_file);
 	}
 
-	sema_up(&syn_sema);
 	return fd;
 }
 
@@ -201,20 +300,10 @@ void call_close(struct res_data res_data)
 {
 	int fd = res_data.rdi;
 
-	sema_down(&syn_sema);
-
-	struct thread *cur = thread_current();
-	struct file *file = find_file_by_Fd(fd);
-	if (file == NULL)
+	if (find_file_by_Fd(fd) != NULL)
 	{
-		sema_up(&syn_sema);
-		return;
+		fdt_install(thread_current(), fd, NULL);
 	}
-	cur->fd_table[fd] = NULL;
-
-	file_close(file);
-	sema_up(&syn_sema);
-
 }
 
 int call_read(struct res_data res_data)
@@ -223,43 +312,27 @@ int call_read(struct res_data res_data)
 	void *buffer = res_data.rsi;
 	unsigned size = res_data.rdx;
 
-	sema_down(&syn_sema);
-	check_addr(buffer);
-
-	if (fd == 1)
-	{
-		sema_up(&syn_sema);
-		return -1;
-	}
-	if (fd == 0)
-	{
-		int byte = input_getc();
-		sema_up(&syn_sema);
-		return byte;
-	}
-
-	struct page *buf_page = spt_find_page(&thread_current()->spt, buffer);
-	if (buf_page != NULL && !buf_page->writable)
-	{
-		sema_up(&syn_sema);
-		exit(-1);
-	}
-
 	struct file *file = find_file_by_Fd(fd);
 	int read_result;
 
 	if (file == NULL)
 	{
-		sema_up(&syn_sema);
 		exit(-1);
 		return -1;
 	}
-	else
+	if (file == STDOUT_FILE)
 	{
-		read_result = file_read(find_file_by_Fd(fd), buffer, size);
+		return -1;
+	}
+	if (file == STDIN_FILE)
+	{
+		read_console(buffer, size);
+		return size;
 	}
-	sema_up(&syn_sema);
 
+	off_t pos = file_tell(file);
+	read_result = rw_pinned(file, buffer, size, pos, false);
+	file_seek(file, pos + read_result);
 	return read_result;
 }
 
@@ -275,7 +348,7 @@ int call_filesize(struct res_data res_data)
 
 	struct file *file = find_file_by_Fd(fd);
 
-	if (file == NULL)
+	if (file == NULL || is_console_file(file))
 	{
 		return 0;
 	}
@@ -289,25 +362,47 @@ int call_fork(struct res_data res_data)
 	
 	const char *thread_name = res_data.rdi;
 	struct intr_frame * f = res_data.f;
+	char name[sizeof curr->name];
 
 	memcpy(&curr->ptf, f, sizeof(struct intr_frame));
 
-	sema_down(&syn_sema);
-
-	check_addr(thread_name);
+	/* Thread names are truncated anyway, so only a bad pointer is
+	 * an error here. */
+	if (strncpy_from_user(name, thread_name, sizeof name) < 0)
+	{
+		exit(-1);
+	}
+	name[sizeof name - 1] = '\0';
 
-	int result = process_fork(thread_name, &curr->ptf);
-	sema_up(&syn_sema);
+	int result = process_fork(name, &curr->ptf);
 
 	return result;
 	
 }
 
+/* Like fork(), but the child runs in our address space and we
+ * sleep until it calls exec() or exit(). */
+int call_vfork(struct res_data res_data)
+{
+	struct thread *curr = thread_current();
+	const char *thread_name = (const char *)res_data.rdi;
+	char name[sizeof curr->name];
+
+	memcpy(&curr->ptf, res_data.f, sizeof(struct intr_frame));
+
+	if (strncpy_from_user(name, thread_name, sizeof name) < 0)
+	{
+		exit(-1);
+	}
+	name[sizeof name - 1] = '\0';
+
+	return process_vfork(name);
+}
+
 int call_exec(struct res_data res_data)
 {
 	const char *file = res_data.rdi;
 	char *file_copy;
-	check_addr(file);
 
 	file_copy = palloc_get_page(PAL_ZERO);
 
@@ -317,7 +412,12 @@ int call_exec(struct res_data res_data)
 		return -1;
 	}
 
-	strlcpy(file_copy, file, strlen(file) + 1);
+	long len = strncpy_from_user(file_copy, file, PGSIZE);
+	if (len < 0 || len == PGSIZE)
+	{
+		palloc_free_page(file_copy);
+		exit(-1);
+	}
 	if (process_exec(file_copy) == -1)
 	{
 
@@ -326,23 +426,91 @@ int call_exec(struct res_data res_data)
 	}
 }
 
+/* Starts FILE as a new child process, passing it ARGV[1] onward as
+ * arguments; like exec(), the program sees FILE as its name.  The
+ * child inherits only the descriptors FDS asks for.  Returns the
+ * child's pid, or -1 if it could not be loaded. */
+int call_spawn(struct res_data res_data)
+{
+	const char *file = (const char *)res_data.rdi;
+	char *const *argv = (char *const *)res_data.rsi;
+	const struct spawn_fd *ufds = (const struct spawn_fd *)res_data.rdx;
+	int fd_cnt = res_data.r10;
+	struct spawn_fd fds[SPAWN_FDS_MAX];
+	char *cmd_line;
+	long len;
+	int i;
+
+	if (fd_cnt < 0 || fd_cnt > SPAWN_FDS_MAX || copy_from_user(fds, ufds, fd_cnt * sizeof *fds) != 0)
+	{
+		exit(-1);
+	}
+	for (i = 0; i < fd_cnt; i++)
+	{
+		if (fds[i].parent_fd != -1 && find_file_by_Fd(fds[i].parent_fd) == NULL)
+		{
+			return -1;
+		}
+	}
+
+	cmd_line = palloc_get_page(0);
+	if (cmd_line == NULL)
+	{
+		return -1;
+	}
+
+	/* Build "FILE ARG1 ARG2 ..." the way exec() expects it. */
+	len = strncpy_from_user(cmd_line, file, PGSIZE);
+	for (i = 1; argv != NULL && len >= 0 && len < PGSIZE; i++)
+	{
+		char *arg;
+		long arg_len;
+
+		if (copy_from_user(&arg, &argv[i], sizeof arg) != 0)
+		{
+			len = -1;
+			break;
+		}
+		if (arg == NULL)
+		{
+			break;
+		}
+		cmd_line[len++] = ' ';
+		arg_len = len < PGSIZE ? strncpy_from_user(cmd_line + len, arg, PGSIZE - len) : 0;
+		len = arg_len < 0 ? -1 : len + arg_len;
+	}
+	if (len < 0 || len >= PGSIZE)
+	{
+		palloc_free_page(cmd_line);
+		if (len < 0)
+		{
+			exit(-1);
+		}
+		return -1;
+	}
+
+	return process_spawn(cmd_line, fds, fd_cnt);
+}
+
 bool call_remove(struct res_data res_data)
 {
 	const char *file = res_data.rdi;
-	sema_down(&syn_sema);
-	check_addr(file);
-	bool return_ans = filesys_remove(file);
-	sema_up(&syn_sema);
-	return return_ans;
+	char name[NAME_MAX + 1];
+
+	if (!copy_in_name(name, file))
+	{
+		return false;
+	}
+	return filesys_remove(name);
 }
 
 void call_seek(struct res_data res_data)
 {
 	int fd = res_data.rdi;
 	unsigned new_pos = res_data.rsi;
-	struct file *cur = thread_current()->fd_table[fd];
+	struct file *cur = find_file_by_Fd(fd);
 
-	if (cur != NULL)
+	if (cur != NULL && !is_console_file(cur))
 	{
 		file_seek(cur, new_pos);
 	}
@@ -353,9 +521,9 @@ void call_seek(struct res_data res_data)
 unsigned call_tell(struct res_data res_data)
 {
 	int fd = res_data.rdi;
-	struct file *cur = thread_current()->fd_table[fd];
+	struct file *cur = find_file_by_Fd(fd);
 
-	if (cur != NULL)
+	if (cur != NULL && !is_console_file(cur))
 	{
 		return file_tell(cur);
 	}
@@ -369,7 +537,7 @@ void * call_mmap(struct res_data res_data)
 	int fd = res_data.r10;
 	off_t offset = res_data.r8;
 
-	if (fd == 0 || fd == 1 || is_kernel_vaddr(addr) || is_kernel_vaddr(addr + length) || pg_round_down(offset) != offset || pg_ofs(addr) != 0)
+	if (is_kernel_vaddr(addr) || is_kernel_vaddr(addr + length) || pg_round_down(offset) != offset || pg_ofs(addr) != 0)
 		return NULL;
 
 	if (addr == 0 || length <= 0 || addr + length <= 0)
@@ -378,7 +546,7 @@ void * call_mmap(struct res_data res_data)
 	}
 	struct file *file = find_file_by_Fd(fd);
 
-	if (file == NULL || offset >= file_length(file))
+	if (file == NULL || is_console_file(file) || offset >= file_length(file))
 	{
 		return NULL;
 	}
@@ -391,47 +559,420 @@ void call_munmap(struct res_data res_data)
 	do_munmap(addr);
 }
 
+/* Copies the IOVCNT-entry iovec array at user address UIOV into
+ * KIOV.  Kills the process on a bad address or count. */
+static void copy_in_iovec(struct iovec *kiov, const struct iovec *uiov, int iovcnt)
+{
+	if (iovcnt < 0 || iovcnt > IOV_MAX || copy_from_user(kiov, uiov, iovcnt * sizeof *uiov) != 0)
+	{
+		exit(-1);
+	}
+}
 
-int add_file_to_fdt(struct file *file)
+/* Services readv() and writev(): transfers each buffer in turn at
+ * the file's current position, stopping at the first short
+ * transfer, then advances the position past everything moved. */
+static int rw_vector(struct res_data res_data, bool write)
 {
-	struct thread *cur = thread_current();
-	struct file **fdt = cur->fd_table;
+	int fd = res_data.rdi;
+	const struct iovec *uiov = (const struct iovec *)res_data.rsi;
+	int iovcnt = res_data.rdx;
+	struct iovec kiov[IOV_MAX];
+	int total = 0;
+	int i;
+
+	struct file *file = find_file_by_Fd(fd);
+	if (file == NULL)
+	{
+		exit(-1);
+	}
+	if (is_console_file(file))
+	{
+		if (file != (write ? STDOUT_FILE : STDIN_FILE))
+			return -1;
+		copy_in_iovec(kiov, uiov, iovcnt);
+		for (i = 0; i < iovcnt; i++)
+		{
+			if (write)
+				write_console(kiov[i].iov_base, kiov[i].iov_len);
+			else
+				read_console(kiov[i].iov_base, kiov[i].iov_len);
+			total += kiov[i].iov_len;
+		}
+		return total;
+	}
+
+	copy_in_iovec(kiov, uiov, iovcnt);
+	off_t pos = file_tell(file);
+	for (i = 0; i < iovcnt; i++)
+	{
+		off_t len = kiov[i].iov_len;
+		off_t done = rw_pinned(file, kiov[i].iov_base, len, pos + total, write);
+		total += done;
+		if (done < len)
+			break;
+	}
+	file_seek(file, pos + total);
+	return total;
+}
+
+int call_readv(struct res_data res_data)
+{
+	return rw_vector(res_data, false);
+}
+
+int call_writev(struct res_data res_data)
+{
+	return rw_vector(res_data, true);
+}
+
+/* Services pread() and pwrite(): one transfer at an explicit
+ * offset that leaves the file position alone, so callers need no
+ * separate seek(). */
+static int rw_positional(struct res_data res_data, bool write)
+{
+	int fd = res_data.rdi;
+	void *buffer = (void *)res_data.rsi;
+	unsigned size = res_data.rdx;
+	off_t offset = res_data.r10;
+
+	struct file *file = find_file_by_Fd(fd);
+	if (file == NULL)
+	{
+		exit(-1);
+	}
+	/* The console has no position to read or write at. */
+	if (is_console_file(file) || offset < 0)
+	{
+		return -1;
+	}
+	return rw_pinned(file, buffer, size, offset, write);
+}
+
+int call_pread(struct res_data res_data)
+{
+	return rw_positional(res_data, false);
+}
+
+int call_pwrite(struct res_data res_data)
+{
+	return rw_positional(res_data, true);
+}
+
+/* Registers the calling process's submission and completion
+ * rings.  They stay ordinary user memory: ring_enter() goes
+ * through the uaccess helpers on every access, so the process may
+ * unmap them at any time and only loses its own batch. */
+int call_ring_setup(struct res_data res_data)
+{
+	struct ring_sq *sq = (struct ring_sq *)res_data.rdi;
+	struct ring_cq *cq = (struct ring_cq *)res_data.rsi;
+	struct thread *curr = thread_current();
+	unsigned head;
+
+	/* Catch a bad address now rather than at the first batch. */
+	if (copy_from_user(&head, &sq->head, sizeof head) != 0 || copy_from_user(&head, &cq->head, sizeof head) != 0)
+	{
+		return -1;
+	}
+	curr->ring_sq = sq;
+	curr->ring_cq = cq;
+	return 0;
+}
+
+/* Returns true if system call NR may be submitted through the
+ * ring.  Only calls that do not depend on the interrupt frame of
+ * the entry that carried them are allowed. */
+static bool ring_op_allowed(int nr)
+{
+	switch (nr)
+	{
+	case SYS_READ:
+	case SYS_WRITE:
+	case SYS_SEEK:
+	case SYS_TELL:
+	case SYS_FILESIZE:
+	case SYS_READV:
+	case SYS_WRITEV:
+	case SYS_PREAD:
+	case SYS_PWRITE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Runs up to TO_SUBMIT queued submissions in order, posting a
+ * completion for each, and returns how many were consumed.  Stops
+ * early when the submission ring runs dry or the completion ring
+ * fills up.  Every entry is copied in and out, so the process
+ * cannot change one underneath us; a ring that has become a bad
+ * address kills the process. */
+int call_ring_enter(struct res_data res_data)
+{
+	unsigned to_submit = res_data.rdi;
+	struct thread *curr = thread_current();
+	struct ring_sq *sq = curr->ring_sq;
+	struct ring_cq *cq = curr->ring_cq;
+	unsigned sq_head, sq_tail, cq_head, cq_tail;
+	unsigned done = 0;
+
+	if (sq == NULL)
+	{
+		return -1;
+	}
 
-	while (cur->fd_idx < 128 && fdt[cur->fd_idx])
+	if (copy_from_user(&sq_head, &sq->head, sizeof sq_head) != 0 || copy_from_user(&cq_tail, &cq->tail, sizeof cq_tail) != 0)
+	{
+		exit(-1);
+	}
+	while (done < to_submit)
 	{
-		cur->fd_idx++;
+		struct ring_sqe sqe;
+		struct ring_cqe cqe;
+
+		/* The process advances these as it goes, so look again
+		 * each time round. */
+		if (copy_from_user(&sq_tail, &sq->tail, sizeof sq_tail) != 0 || copy_from_user(&cq_head, &cq->head, sizeof cq_head) != 0)
+		{
+			exit(-1);
+		}
+		if (sq_head == sq_tail || cq_tail - cq_head >= RING_ENTRIES)
+			break;
+
+		if (copy_from_user(&sqe, &sq->sqes[sq_head % RING_ENTRIES], sizeof sqe) != 0)
+		{
+			exit(-1);
+		}
+		sq_head++;
+		if (copy_to_user(&sq->head, &sq_head, sizeof sq_head) != 0)
+		{
+			exit(-1);
+		}
+
+		cqe.user_data = sqe.user_data;
+		cqe.res = -1;
+		if (ring_op_allowed(sqe.nr))
+		{
+			struct res_data args = {
+				.rdi = sqe.args[0],
+				.rsi = sqe.args[1],
+				.rdx = sqe.args[2],
+				.r10 = sqe.args[3],
+				.f = res_data.f
+			};
+			cqe.res = syscall_handlers[sqe.nr](args);
+		}
+		if (copy_to_user(&cq->cqes[cq_tail % RING_ENTRIES], &cqe, sizeof cqe) != 0)
+		{
+			exit(-1);
+		}
+		cq_tail++;
+		if (copy_to_user(&cq->tail, &cq_tail, sizeof cq_tail) != 0)
+		{
+			exit(-1);
+		}
+		done++;
 	}
+	return done;
+}
+
+/* Makes room in T's fd table for descriptor FD, doubling the
+ * table as often as needed.  Returns false if FD is out of range
+ * or memory runs out. */
+static bool fdt_reserve(struct thread *t, int fd)
+{
+	int cnt = t->fd_cnt;
+	struct file **table;
 
-	if (cur->fd_idx >= 128)
+	if (fd < 0 || fd >= FDCOUNT_LIMIT)
+	{
+		return false;
+	}
+	if (fd < cnt)
+	{
+		return true;
+	}
+
+	while (cnt <= fd)
+		cnt *= 2;
+	if (cnt > FDCOUNT_LIMIT)
+		cnt = FDCOUNT_LIMIT;
+
+	table = realloc(t->fd_table, cnt * sizeof *table);
+	if (table == NULL)
+	{
+		return false;
+	}
+	memset(table + t->fd_cnt, 0, (cnt - t->fd_cnt) * sizeof *table);
+	t->fd_table = table;
+	t->fd_cnt = cnt;
+	return true;
+}
+
+/* Installs FILE under the lowest free descriptor of the current
+ * process and returns it, or -1 if none is left. */
+int add_file_to_fdt(struct file *file)
+{
+	struct thread *cur = thread_current();
+	size_t fd = bitmap_scan(cur->fd_map, 0, 1, false);
+
+	if (fd == BITMAP_ERROR || !fdt_reserve(cur, fd))
 	{
 		return -1;
 	}
 
-	fdt[cur->fd_idx] = file;
-	return cur->fd_idx;
+	bitmap_mark(cur->fd_map, fd);
+	cur->fd_table[fd] = file;
+	return fd;
 }
 
+/* Returns the file open as FD in the current process, which may be
+ * STDIN_FILE or STDOUT_FILE, or a null pointer if FD is not
+ * open. */
 struct file *find_file_by_Fd(int fd)
 {
 	struct thread *cur = thread_current();
 
-	if (fd < 0 || fd >= 128)
+	if (fd < 0 || fd >= cur->fd_cnt)
 	{
 		return NULL;
 	}
 	return cur->fd_table[fd];
 }
 
-void check_addr(const uint64_t *addr)
+/* Makes NEWFD refer to the same open file as OLDFD, closing
+ * whatever NEWFD had open first.  The two descriptors then share
+ * one file position. */
+int call_dup2(struct res_data res_data)
 {
-	struct thread *curr = thread_current();
+	int oldfd = res_data.rdi;
+	int newfd = res_data.rsi;
+	struct thread *cur = thread_current();
+	struct file *file = find_file_by_Fd(oldfd);
 
-	// pml4_get_page는 실제 적재되어 있어야 NULL반환 안해줌.. 하지만 pml4e_walk는 실제 적재되어 있지 않고 매핑만 되어있어도 되서 pml4e walk를 쓴다
-	// 유저 어드레스는 왜 체크안해도 되징? 커널 영역도 가능한것인가?.? pml4_get_page를 하려면 유저 어드레스 여야해 assertion 걸려서.. 근데 이제는 커널영역에 있는 것도
-	// 막 가져오나??
-	if (addr == NULL || pml4e_walk(curr->pml4, addr, false) == NULL)
+	if (file == NULL || !fdt_reserve(cur, newfd))
 	{
-		sema_up(&syn_sema);
-		exit(-1);
+		return -1;
+	}
+	if (oldfd == newfd)
+	{
+		return newfd;
+	}
+
+	fdt_install(cur, newfd, is_console_file(file) ? file : file_share(file));
+	return newfd;
+}
+
+/* Makes FILE, which may be null, T's descriptor FD, closing
+ * whatever FD had open before.  Returns false if FD is out of
+ * range or the table cannot grow to hold it. */
+bool fdt_install(struct thread *t, int fd, struct file *file)
+{
+	if (!fdt_reserve(t, fd))
+	{
+		return false;
+	}
+
+	struct file *old = t->fd_table[fd];
+	if (old != NULL && !is_console_file(old))
+	{
+		file_close(old);
+	}
+	t->fd_table[fd] = file;
+	bitmap_set(t->fd_map, fd, file != NULL);
+	return true;
+}
+
+/* Gives new thread T an fd table with the console open as fds 0
+ * and 1. */
+bool fdt_init(struct thread *t)
+{
+	t->fd_table = calloc(FDT_INIT_CNT, sizeof *t->fd_table);
+	t->fd_map = bitmap_create(FDCOUNT_LIMIT);
+	if (t->fd_table == NULL || t->fd_map == NULL)
+	{
+		free(t->fd_table);
+		if (t->fd_map != NULL)
+			bitmap_destroy(t->fd_map);
+		return false;
+	}
+	t->fd_cnt = FDT_INIT_CNT;
+	t->fd_table[0] = STDIN_FILE;
+	t->fd_table[1] = STDOUT_FILE;
+	bitmap_set_multiple(t->fd_map, 0, 2, true);
+	return true;
+}
+
+/* Replaces DST's fd table with a copy of SRC's, for fork().  Only
+ * open descriptors are visited.  Descriptors that share a file in
+ * SRC share the duplicate in DST: the first of them to be copied
+ * leaves the copy in the file's FORK_COPY for the rest to find. */
+bool fdt_duplicate(struct thread *dst, struct thread *src)
+{
+	bool success = true;
+	size_t fd;
+
+	for (fd = bitmap_scan(dst->fd_map, 0, 1, true); fd != BITMAP_ERROR;
+		 fd = bitmap_scan(dst->fd_map, fd + 1, 1, true))
+		fdt_install(dst, fd, NULL);
+
+	for (fd = bitmap_scan(src->fd_map, 0, 1, true); fd != BITMAP_ERROR;
+		 fd = bitmap_scan(src->fd_map, fd + 1, 1, true))
+	{
+		struct file *file = src->fd_table[fd];
+		struct file *copy;
+
+		if (!fdt_reserve(dst, fd))
+		{
+			success = false;
+			break;
+		}
+		if (is_console_file(file))
+		{
+			copy = file;
+		}
+		else if (file->fork_copy != NULL)
+		{
+			copy = file_share(file->fork_copy);
+		}
+		else if ((copy = file_duplicate(file)) == NULL)
+		{
+			success = false;
+			break;
+		}
+		else if (file->ref_cnt > 1)
+		{
+			file->fork_copy = copy;
+		}
+		dst->fd_table[fd] = copy;
+		bitmap_mark(dst->fd_map, fd);
+	}
+
+	/* Leave no marker behind for the next fork. */
+	for (fd = bitmap_scan(src->fd_map, 0, 1, true); fd != BITMAP_ERROR;
+		 fd = bitmap_scan(src->fd_map, fd + 1, 1, true))
+		if (!is_console_file(src->fd_table[fd]))
+			src->fd_table[fd]->fork_copy = NULL;
+	return success;
+}
+
+/* Closes every descriptor T has open and frees its fd table. */
+void fdt_destroy(struct thread *t)
+{
+	size_t fd;
+
+	if (t->fd_table == NULL)
+	{
+		return;
 	}
+	for (fd = bitmap_scan(t->fd_map, 0, 1, true); fd != BITMAP_ERROR;
+		 fd = bitmap_scan(t->fd_map, fd + 1, 1, true))
+		if (!is_console_file(t->fd_table[fd]))
+			file_close(t->fd_table[fd]);
+
+	free(t->fd_table);
+	bitmap_destroy(t->fd_map);
+	t->fd_table = NULL;
+	t->fd_map = NULL;
 }
@@ -0,0 +1,74 @@
+#include "userprog/uaccess.h"
+#include <stdint.h>
+#include "threads/vaddr.h"
+
+/* Exception table entry: a faulting instruction and where to
+ * resume. */
+struct exception_entry {
+	uintptr_t insn;
+	uintptr_t fixup;
+};
+
+/* Bounds of the __ex_table section, from kernel.lds.S. */
+extern const struct exception_entry __start_ex_table[], __stop_ex_table[];
+
+size_t uaccess_copy (void *dst, const void *src, size_t size);
+long uaccess_strncpy (char *dst, const char *src, size_t size);
+
+/* Returns true if [UADDR, UADDR + SIZE) lies wholly in user space. */
+static bool
+user_range_ok (const void *uaddr, size_t size) {
+	uintptr_t start = (uintptr_t) uaddr;
+	return start + size >= start && !is_kernel_vaddr (start + size - (size != 0));
+}
+
+/* Copies SIZE bytes from user address USRC to DST.  Returns the
+ * number of bytes that could not be copied, 0 on success. */
+size_t
+copy_from_user (void *dst, const void *usrc, size_t size) {
+	if (!user_range_ok (usrc, size))
+		return size;
+	return uaccess_copy (dst, usrc, size);
+}
+
+/* Copies SIZE bytes from SRC to user address UDST.  Returns the
+ * number of bytes that could not be copied, 0 on success. */
+size_t
+copy_to_user (void *udst, const void *src, size_t size) {
+	if (!user_range_ok (udst, size))
+		return size;
+	return uaccess_copy (udst, src, size);
+}
+
+/* Copies the null-terminated string at user address USRC into DST,
+ * which has room for SIZE bytes.  Returns the length of the string,
+ * SIZE if it does not fit (DST is then not terminated), or -1 if
+ * USRC is not readable. */
+long
+strncpy_from_user (char *dst, const char *usrc, size_t size) {
+	uintptr_t start = (uintptr_t) usrc;
+
+	if (is_kernel_vaddr (start))
+		return -1;
+	/* Never run past the end of user space, even if the string does. */
+	if (size > KERN_BASE - start) {
+		long len = uaccess_strncpy (dst, usrc, KERN_BASE - start);
+		return len == (long) (KERN_BASE - start) ? -1 : len;
+	}
+	return uaccess_strncpy (dst, usrc, size);
+}
+
+/* Called by the page fault handler for a kernel-mode fault it could
+ * not resolve.  If F's instruction is a user accessor, redirects it
+ * to its fixup and returns true. */
+bool
+uaccess_fixup (struct intr_frame *f) {
+	const struct exception_entry *e;
+
+	for (e = __start_ex_table; e < __stop_ex_table; e++)
+		if (e->insn == f->rip) {
+			f->rip = e->fixup;
+			return true;
+		}
+	return false;
+}
@@ -1,9 +1,15 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
 #include "vm/vm.h"
+#include <stdio.h>
+#include <string.h>
 #include "devices/disk.h"
 #include "bitmap.h"
+#include "threads/malloc.h"
 #include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/trace.h"
 
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
@@ -20,13 +26,165 @@ static const struct page_operations anon_ops = {
 };
 
 static struct bitmap *swap_bitmap;
+
+/* disk_sec of a page that is not on the swap disk. */
+#define NO_SLOT ((disk_sector_t) -1)
+
+/* Slots handed out to a new stream are taken from a run of this many
+ * free ones, so that the stream can keep going. */
+#define SWAP_CLUSTER 8
+
+/* Number of streams of swap-outs followed at once. */
+#define SWAP_STREAMS 4
+
+/* A process swapping out consecutive pages.  Its next page, at
+ * NEXT_VA, goes into the slot after the last one. */
+struct swap_stream {
+	uint64_t *pml4;
+	void *next_va;
+	size_t next_slot;
+};
+static struct swap_stream streams[SWAP_STREAMS];
+static size_t stream_victim;
+
+/* Slots after the faulting one read in with it. */
+#define SWAP_READAHEAD 4
+
+/* Upper bound on pages held in the swap cache. */
+#define SWAP_CACHE_MAX 16
+
+/* A slot read ahead of need.  The slot stays allocated until the
+ * page is swapped in. */
+struct swap_cache_entry {
+	struct list_elem elem;
+	size_t slot;
+	void *kva;
+};
+
+/* Read-ahead slots, oldest first. */
+static struct list swap_cache;
+static size_t swap_cache_cnt;
+
+/* Protects the slot bitmap, the streams and the swap cache. */
+static struct lock swap_lock;
+
+static long long swap_reads;       /* Slots read on a fault. */
+static long long swap_readaheads;  /* Slots read ahead. */
+static long long swap_cache_hits;  /* Faults served by the cache. */
+
 /* Initialize the data for anonymous pages */
 void vm_anon_init(void)
 {
 	/* TODO: Set up the swap_disk. */
 
 	swap_disk = disk_get(1,1);
-	swap_bitmap = bitmap_create(disk_size(swap_disk));
+	swap_bitmap = bitmap_create(disk_size(swap_disk) / SECTOR_PER_DISK);
+	list_init(&swap_cache);
+	lock_init(&swap_lock);
+	vm_zswap_init();
+}
+
+/* Reads swap slot SLOT into KVA. */
+static void
+slot_read(size_t slot, void *kva)
+{
+	for (int i = 0 ; i < SECTOR_PER_DISK ; i++) {
+		disk_read (swap_disk, slot*SECTOR_PER_DISK+i, kva+(i * DISK_SECTOR_SIZE));
+	}
+}
+
+/* Picks a free swap slot for the page at VA of the process whose
+ * page table is PML4.  A page that follows one the same process just
+ * swapped out goes in the next slot, so that it can be read back in
+ * with it; other pages start a new stream in a run of free slots. */
+static size_t
+slot_alloc(uint64_t *pml4, void *va)
+{
+	struct swap_stream *s;
+	size_t slot;
+	int i;
+
+	ASSERT(lock_held_by_current_thread(&swap_lock));
+
+	for (i = 0; i < SWAP_STREAMS; i++)
+	{
+		s = &streams[i];
+		if (s->pml4 == pml4 && s->next_va == va && s->next_slot < bitmap_size(swap_bitmap) && !bitmap_test(swap_bitmap, s->next_slot))
+			goto found;
+	}
+
+	s = &streams[stream_victim++ % SWAP_STREAMS];
+	slot = bitmap_scan(swap_bitmap, 0, SWAP_CLUSTER, false);
+	if (slot == BITMAP_ERROR)
+		slot = bitmap_scan(swap_bitmap, 0, 1, false);
+	if (slot == BITMAP_ERROR)
+		PANIC("swap disk is full");
+	s->pml4 = pml4;
+	s->next_slot = slot;
+
+found:
+	slot = s->next_slot++;
+	s->next_va = va + PGSIZE;
+	bitmap_mark(swap_bitmap, slot);
+	return slot;
+}
+
+/* Returns the swap cache entry holding SLOT, or NULL. */
+static struct swap_cache_entry *
+cache_find(size_t slot)
+{
+	struct list_elem *e;
+
+	for (e = list_begin(&swap_cache); e != list_end(&swap_cache); e = list_next(e))
+	{
+		struct swap_cache_entry *c = list_entry(e, struct swap_cache_entry, elem);
+		if (c->slot == slot)
+			return c;
+	}
+	return NULL;
+}
+
+/* Removes C from the swap cache and frees it. */
+static void
+cache_free(struct swap_cache_entry *c)
+{
+	list_remove(&c->elem);
+	swap_cache_cnt--;
+	palloc_free_page(c->kva);
+	free(c);
+}
+
+/* Reads the allocated slots after SLOT that are not cached yet into
+ * the swap cache, making room by dropping the oldest entries. */
+static void
+slot_readahead(size_t slot)
+{
+	size_t s;
+
+	for (s = slot + 1; s < slot + SWAP_READAHEAD && s < bitmap_size(swap_bitmap); s++)
+	{
+		struct swap_cache_entry *c;
+
+		if (!bitmap_test(swap_bitmap, s) || cache_find(s) != NULL)
+			continue;
+		if (swap_cache_cnt >= SWAP_CACHE_MAX)
+			cache_free(list_entry(list_front(&swap_cache), struct swap_cache_entry, elem));
+
+		c = malloc(sizeof *c);
+		if (c == NULL)
+			return;
+		c->kva = palloc_get_page(0);
+		if (c->kva == NULL)
+		{
+			free(c);
+			return;
+		}
+		c->slot = s;
+		slot_read(s, c->kva);
+		list_push_back(&swap_cache, &c->elem);
+		swap_cache_cnt++;
+		swap_readaheads++;
+	}
 }
 
 /* Initialize the file mapping */
@@ -36,6 +194,9 @@ bool anon_initializer(struct page *page, enum vm_type type, void *kva)
 	page->operations = &anon_ops;
 
 	struct anon_page *anon_page = &page->anon;
+	anon_page->disk_sec = NO_SLOT;
+	anon_page->zentry = NULL;
+	return true;
 }
 
 /* Swap in the page by read contents from the swap disk. */
@@ -43,46 +204,93 @@ static bool
 anon_swap_in(struct page *page, void *kva)
 {
 	struct anon_page *anon_page = &page->anon;
+	trace_event(TRACE_SWAP_IN, (uint64_t)page->va, (uint64_t)kva);
+	if (zswap_load(page, kva))
+		return true;
+
 	size_t bit_no = anon_page->disk_sec;
+	struct swap_cache_entry *c;
 
-	for (int i = 0 ; i < SECTOR_PER_DISK ; i++) {
-		disk_read (swap_disk, bit_no*SECTOR_PER_DISK+i, kva+(i * DISK_SECTOR_SIZE));
+	lock_acquire(&swap_lock);
+	c = cache_find(bit_no);
+	if (c != NULL)
+	{
+		page_copy(kva, c->kva);
+		cache_free(c);
+		swap_cache_hits++;
 	}
-	bitmap_flip(swap_bitmap, bit_no);
-	anon_page->disk_sec = NULL;
-	return true;
+	else
+	{
+		slot_read(bit_no, kva);
+		swap_reads++;
+		slot_readahead(bit_no);
+	}
+	bitmap_reset(swap_bitmap, bit_no);
+	lock_release(&swap_lock);
+	anon_page->disk_sec = NO_SLOT;
 	return true;
 }
 
 
-static bool
-anon_swap_out (struct page *page) {
+/* Writes the contents of PAGE, at KVA, to a free swap slot.  PML4
+ * is the page table of the process PAGE belongs to. */
+void
+anon_swap_write (struct page *page, const void *kva, uint64_t *pml4) {
 	struct anon_page *anon_page = &page->anon;
-	
-	size_t bit_idx = bitmap_scan(swap_bitmap, 0, 1, false);
-	bitmap_flip(swap_bitmap, bit_idx);
 
-	void* tmp = page->frame->kva;
+	lock_acquire(&swap_lock);
+	size_t bit_idx = slot_alloc(pml4, page->va);
+
 	for (int i = 0 ; i < SECTOR_PER_DISK ; i++) {
-		disk_write (swap_disk, bit_idx*SECTOR_PER_DISK+i, page->va+(i * DISK_SECTOR_SIZE));
+		disk_write (swap_disk, bit_idx*SECTOR_PER_DISK+i, kva+(i * DISK_SECTOR_SIZE));
 	}
-	pml4_clear_page(thread_current()->pml4, page->va);
-	page->frame = NULL;
+	lock_release(&swap_lock);
 	anon_page->disk_sec = bit_idx;
 }
 
+/* Prints swap statistics. */
+void
+anon_print_stats (void) {
+	printf("Swap: %lld slots read on fault, %lld read ahead, %lld cache hits\n",
+		   swap_reads, swap_readaheads, swap_cache_hits);
+}
+
+/* Swap out the page, compressed into memory if it can be, and to
+ * the swap disk otherwise. */
+static bool
+anon_swap_out (struct page *page) {
+	void *kva = page->frame->kva;
+
+	trace_event(TRACE_SWAP_OUT, (uint64_t)page->va, (uint64_t)kva);
+	if (!zswap_store(page, kva))
+		anon_swap_write(page, kva, page->frame->pml4);
+	pml4_clear_page(page->frame->pml4, page->va);
+	page->frame = NULL;
+	return true;
+}
+
 /* Destroy the anonymous page. PAGE will be freed by the caller. */
 static void
 anon_destroy(struct page *page)
 {
 	struct anon_page *anon_page = &page->anon;
 
-	struct frame *f = page->frame;
-	if (f != NULL)
+	vm_hold_frame(page);
+	zswap_drop(page);
+	if (anon_page->disk_sec != NO_SLOT)
 	{
-		pml4_clear_page(thread_current()->pml4, page->va);
-		list_remove(&f->list_elem);
-		palloc_free_page(f->kva);
-		free(f);
+		struct swap_cache_entry *c;
+
+		/* The slot may be handed out again, so it must not stay
+		 * behind in the swap cache. */
+		lock_acquire(&swap_lock);
+		c = cache_find(anon_page->disk_sec);
+		if (c != NULL)
+			cache_free(c);
+		bitmap_reset(swap_bitmap, anon_page->disk_sec);
+		lock_release(&swap_lock);
+		anon_page->disk_sec = NO_SLOT;
 	}
+
+	vm_free_frame(page);
 }
@@ -38,7 +38,7 @@ file_backed_swap_in(struct page *page, void *kva)
 {
 	struct file_page *file_page = &page->file;
 	// disk
-	file_read_at(file_page->file, page->va, file_page->read_bytes, file_page->offset);
+	file_read_at(file_page->file, kva, file_page->read_bytes, file_page->offset);
 
 	return true;
 }
@@ -66,22 +66,13 @@ file_backed_destroy(struct page *page)
 {
 	struct file_page *file_page = &page->file;
 
+	vm_hold_frame(page);
 	if (pml4_is_dirty(thread_current()->pml4, page->va))
 	{
 		off_t write_bytes = file_write_at(file_page->file, page->va, file_page->read_bytes, file_page->offset);
 	}
 
-	// do_munmap(page->va);
-
-	// pml4_clear_page(thread_current()->pml4, page->va);
-	// struct frame *f = page->frame;
-	// if (f != NULL)
-	// {
-	// 	// printf("🎁: %p\n", f->kva);
-	// 	list_remove(&f->list_elem);
-	// 	// palloc_free_page(f->kva);
-	// 	free(f);
-	// }
+	vm_free_frame(page);
 	file_close(file_page->file);
 }
 
@@ -162,6 +153,7 @@ void do_munmap(void *addr)
 	while (page_count > 0)
 	{
 		page = spt_find_page(&thread_current()->spt, addr);
+		vm_hold_frame(page);
 		if (pml4_is_dirty(thread_current()->pml4, addr))
 		{
 			if (page != NULL)
@@ -172,14 +164,8 @@ void do_munmap(void *addr)
 		}
 
 		pml4_clear_page(thread_current()->pml4, addr);
-		struct frame *f = page->frame;
-		if (f != NULL)
-		{
-			list_remove(&f->list_elem);
-			palloc_free_page(f->kva);
-			free(f);
-		}
-		hash_delete(&thread_current()->spt.hash_table, &page->spt_elem);
+		vm_free_frame(page);
+		ohash_delete(&thread_current()->spt.pages, &page->spt_elem);
 
 		addr += PGSIZE;
 		page_count--;
@@ -0,0 +1,260 @@
+/* ksm.c: Merges anonymous pages whose contents are identical.
+ *
+ * A low-priority kernel thread walks the frame table a few frames at
+ * a time.  A frame whose contents hash the same on two visits is
+ * taken to be stable; if another frame holds the same bytes, both
+ * pages are remapped read-only onto one struct ksm_frame and the
+ * spare memory is freed.  Writing to a merged page takes a
+ * protection fault, and vm_handle_wp() copies it back out.
+ *
+ * The thread does its work holding frame_lock, one frame at a time,
+ * so the pages it remaps cannot change under it.  Its place in the
+ * frame table is the next frame itself, which whoever takes that
+ * frame off the table moves along with ksm_forget().  It never
+ * allocates or frees while holding the lock, since that could
+ * block. */
+
+#include "vm/vm.h"
+#include "vm/ksm.h"
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+
+/* Frames examined per wake-up, and the sleep between wake-ups. */
+#define KSM_SCAN_PAGES 64
+#define KSM_SCAN_TICKS (TIMER_FREQ / 10)
+
+/* Buckets of the table of merged frames. */
+#define KSM_BUCKETS 64
+
+extern struct list frame_list;
+extern struct spinlock frame_lock;
+
+/* Merged frames, bucketed by checksum.  Lists rather than a
+ * struct hash, so that inserting never allocates.  Protected by
+ * frame_lock. */
+static struct list stable[KSM_BUCKETS];
+
+/* Next frame_list element to examine: a null pointer at the start of
+ * a pass, the list's end once the pass is over.  Protected by
+ * frame_lock. */
+static struct list_elem *scan_cursor;
+
+static long long pages_scanned;  /* Frames examined. */
+static long long pages_merged;   /* Pages remapped onto a merged frame. */
+static long long pages_broken;   /* Merged pages copied out on write. */
+
+static void ksm_daemon(void *aux);
+
+/* Starts the merging thread. */
+void vm_ksm_init(void)
+{
+	size_t i;
+
+	for (i = 0; i < KSM_BUCKETS; i++)
+		list_init(&stable[i]);
+	thread_create("ksmd", PRI_MIN, ksm_daemon, NULL);
+}
+
+/* Returns true if F holds an anonymous page that may be merged. */
+static bool
+mergeable(struct frame *f)
+{
+	return f->page != NULL && f->pin_cnt == 0 && f->pml4 != NULL && f->page->operations->type == VM_ANON && !pml4_is_huge(f->pml4, f->page->va);
+}
+
+/* Returns the merged frame holding the same bytes as F, if any. */
+static struct ksm_frame *
+stable_find(struct frame *f, unsigned checksum)
+{
+	struct list *bucket = &stable[checksum % KSM_BUCKETS];
+	struct list_elem *e;
+
+	for (e = list_begin(bucket); e != list_end(bucket); e = list_next(e))
+	{
+		struct ksm_frame *k = list_entry(e, struct ksm_frame, elem);
+		if (k->checksum == checksum && !memcmp(k->frame.kva, f->kva, PGSIZE))
+			return k;
+	}
+	return NULL;
+}
+
+/* Returns another mergeable frame holding the same bytes as F, if
+ * any.  Its recorded checksum is only a hint. */
+static struct frame *
+find_twin(struct frame *f, unsigned checksum)
+{
+	struct list_elem *e;
+
+	for (e = list_begin(&frame_list); e != list_end(&frame_list); e = list_next(e))
+	{
+		struct frame *g = list_entry(e, struct frame, list_elem);
+		if (g != f && g->checksum == checksum && mergeable(g) && !memcmp(g->kva, f->kva, PGSIZE))
+			return g;
+	}
+	return NULL;
+}
+
+/* Remaps F's page read-only onto K and takes F off the frame
+ * table.  F's memory is the caller's to free. */
+static void
+merge_into(struct frame *f, struct ksm_frame *k)
+{
+	struct page *page = f->page;
+
+	/* The PTE exists and is not part of a huge mapping, so this
+	 * neither allocates nor fails. */
+	pml4_set_page(f->pml4, page->va, k->frame.kva, false);
+	page->frame = &k->frame;
+	k->ref_cnt++;
+	ksm_forget(f);
+	list_remove(&f->list_elem);
+	pages_merged++;
+}
+
+/* Examines the next frame of the frame table and merges it if it
+ * can.  Must be called with frame_lock held.  Frames unlinked by a
+ * merge are left in DEAD for the caller to free, and *SPARE is used
+ * up if a new merged frame is needed.  Returns false at the end of
+ * a pass over the table. */
+static bool
+scan_next(struct ksm_frame **spare, struct frame *dead[2])
+{
+	struct list_elem *e;
+	struct ksm_frame *k;
+	struct frame *f, *twin;
+	unsigned checksum;
+
+	ASSERT(spin_held(&frame_lock));
+
+	e = scan_cursor != NULL ? scan_cursor : list_begin(&frame_list);
+	if (e == list_end(&frame_list))
+	{
+		scan_cursor = NULL;
+		return false;
+	}
+	scan_cursor = list_next(e);
+
+	f = list_entry(e, struct frame, list_elem);
+	if (!mergeable(f))
+		return true;
+	pages_scanned++;
+
+	/* Pages still being written are not worth merging. */
+	checksum = hash_bytes(f->kva, PGSIZE);
+	if (checksum != f->checksum)
+	{
+		f->checksum = checksum;
+		return true;
+	}
+
+	k = stable_find(f, checksum);
+	if (k == NULL)
+	{
+		twin = find_twin(f, checksum);
+		if (twin == NULL)
+			return true;
+
+		/* F's memory becomes the merged frame. */
+		k = *spare;
+		*spare = NULL;
+		k->frame = (struct frame){.kva = f->kva, .merged = true};
+		k->checksum = checksum;
+		k->ref_cnt = 0;
+		list_push_back(&stable[checksum % KSM_BUCKETS], &k->elem);
+		f->kva = NULL;
+
+		merge_into(twin, k);
+		dead[1] = twin;
+	}
+	merge_into(f, k);
+	dead[0] = f;
+	return true;
+}
+
+/* Body of the merging thread. */
+static void
+ksm_daemon(void *aux UNUSED)
+{
+	struct ksm_frame *spare = NULL;
+
+	for (;;)
+	{
+		int i;
+
+		timer_sleep(KSM_SCAN_TICKS);
+		for (i = 0; i < KSM_SCAN_PAGES; i++)
+		{
+			struct frame *dead[2] = {NULL, NULL};
+			bool more;
+			int j;
+
+			if (spare == NULL && (spare = malloc(sizeof *spare)) == NULL)
+				break;
+
+			spin_lock(&frame_lock);
+			more = scan_next(&spare, dead);
+			spin_unlock(&frame_lock);
+
+			for (j = 0; j < 2; j++)
+				if (dead[j] != NULL)
+				{
+					if (dead[j]->kva != NULL)
+						palloc_free_page(dead[j]->kva);
+					free(dead[j]);
+				}
+			if (!more)
+				break;
+		}
+	}
+}
+
+/* Drops one page's reference to the merged frame FRAME, freeing it
+ * with the last one.  The caller has already unmapped the page. */
+void ksm_put(struct frame *frame)
+{
+	struct ksm_frame *k = (struct ksm_frame *)frame;
+	bool last;
+
+	ASSERT(frame->merged);
+
+	spin_lock(&frame_lock);
+	last = --k->ref_cnt == 0;
+	if (last)
+		list_remove(&k->elem);
+	spin_unlock(&frame_lock);
+
+	if (last)
+	{
+		palloc_free_page(k->frame.kva);
+		free(k);
+	}
+}
+
+/* Like ksm_put(), for a page that was written to and got a private
+ * copy of FRAME. */
+void ksm_break(struct frame *frame)
+{
+	pages_broken++;
+	ksm_put(frame);
+}
+
+/* Moves the scan past FRAME, which is about to leave the frame
+ * table.  Must be called with frame_lock held. */
+void ksm_forget(struct frame *frame)
+{
+	ASSERT(spin_held(&frame_lock));
+
+	if (scan_cursor == &frame->list_elem)
+		scan_cursor = list_next(scan_cursor);
+}
+
+/* Prints page merging statistics. */
+void ksm_print_stats(void)
+{
+	printf("KSM: %lld pages scanned, %lld merged, %lld broken\n",
+		   pages_scanned, pages_merged, pages_broken);
+}
@@ -2,4 +2,7 @@ vm_SRC = vm/vm.c          # Main api proxy
 vm_SRC += vm/uninit.c     # Uninitialized page
 vm_SRC += vm/anon.c       # Anonymous page
 vm_SRC += vm/file.c       # File mapped page
+vm_SRC += vm/text.c       # Shared program text
+vm_SRC += vm/ksm.c        # Same-page merging
+vm_SRC += vm/zswap.c      # Compressed swap cache
 vm_SRC += vm/inspect.c    # Testing utility
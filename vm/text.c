@@ -0,0 +1,140 @@
+/* text.c: Read-only program text shared between processes. */
+
+#include "vm/vm.h"
+#include "vm/text.h"
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+
+static bool text_swap_in(struct page *page, void *kva);
+static void text_destroy(struct page *page);
+
+static const struct page_operations text_ops = {
+	.swap_in = text_swap_in,
+	.swap_out = NULL,
+	.destroy = text_destroy,
+	.type = VM_TEXT,
+};
+
+/* Guards the KVA and LOADING members of every text frame.  It is
+ * never held across I/O; faults on a frame being read in wait on
+ * TEXT_LOADED instead. */
+static struct lock text_lock;
+static struct condition text_loaded;
+
+void vm_text_init(void)
+{
+	lock_init(&text_lock);
+	cond_init(&text_loaded);
+}
+
+/* Adds a read-only page at UPAGE whose contents are SHARED, to the
+ * current process's SPT.  Unlike other pages it is not born uninit:
+ * there is nothing per-process to set up on first touch. */
+bool vm_alloc_text_page(void *upage, struct text_frame *shared)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	struct page *page;
+
+	if (spt_find_page(spt, upage) != NULL)
+		return false;
+
+	page = malloc(sizeof *page);
+	if (page == NULL)
+		return false;
+
+	*page = (struct page){
+		.operations = &text_ops,
+		.va = upage,
+		.frame = NULL,
+		.writable = false,
+		.text = (struct text_page){.shared = shared},
+	};
+	if (!spt_insert_page(spt, page))
+	{
+		free(page);
+		return false;
+	}
+	return true;
+}
+
+/* Reads TEXT's contents into a new page and returns it, or NULL if
+ * there is no memory or the file is short. */
+static void *
+text_load(struct text_frame *text)
+{
+	void *kva = palloc_get_page(PAL_USER);
+
+	if (kva == NULL)
+		kva = vm_steal_page();
+	if (kva == NULL)
+		return NULL;
+	if (file_read_at(text->file, kva, text->read_bytes, text->ofs) != (off_t)text->read_bytes)
+	{
+		palloc_free_page(kva);
+		return NULL;
+	}
+	memset(kva + text->read_bytes, 0, PGSIZE - text->read_bytes);
+	return kva;
+}
+
+/* Maps PAGE to its shared frame, reading the frame in first if no
+ * process has touched it yet.  Only the first process to fault does
+ * the read; others faulting on the same frame meanwhile wait for
+ * it. */
+bool text_claim_page(struct page *page)
+{
+	struct text_frame *text = page->text.shared;
+	void *kva;
+
+	lock_acquire(&text_lock);
+	while (text->loading)
+		cond_wait(&text_loaded, &text_lock);
+	if (text->frame.kva == NULL)
+	{
+		text->loading = true;
+		lock_release(&text_lock);
+		kva = text_load(text);
+		lock_acquire(&text_lock);
+		text->frame.kva = kva;
+		text->loading = false;
+		cond_broadcast(&text_loaded, &text_lock);
+	}
+	kva = text->frame.kva;
+	lock_release(&text_lock);
+
+	if (kva == NULL || !pml4_set_page(thread_current()->pml4, page->va, kva, false))
+		return false;
+	page->frame = &text->frame;
+	return true;
+}
+
+/* The frame was filled by text_claim_page(); nothing is left to do. */
+static bool
+text_swap_in(struct page *page UNUSED, void *kva UNUSED)
+{
+	return true;
+}
+
+/* Unmaps PAGE.  The frame belongs to the executable image and
+ * outlives this process. */
+static void
+text_destroy(struct page *page)
+{
+	if (page->frame != NULL)
+	{
+		pml4_clear_page(thread_current()->pml4, page->va);
+		page->frame = NULL;
+	}
+}
+
+/* Releases TEXT's frame.  No process may still map it. */
+void text_frame_free(struct text_frame *text)
+{
+	if (text->frame.kva != NULL)
+	{
+		palloc_free_page(text->frame.kva);
+		text->frame.kva = NULL;
+	}
+}
@@ -11,6 +11,7 @@
 #include "vm/vm.h"
 #include "vm/uninit.h"
 #include "userprog/process.h"
+#include "threads/mmu.h"
 
 static bool uninit_initialize(struct page *page, void *kva);
 static void uninit_destroy(struct page *page);
@@ -65,6 +66,11 @@ static void
 uninit_destroy(struct page *page)
 {
 	struct uninit_page *uninit = &page->uninit;
+
+	/* Never written, but maybe mapped to the shared zero page, or
+	 * given a frame whose load failed. */
+	vm_hold_frame(page);
+	vm_free_frame(page);
 	/* TODO: Fill this function.
 	 * TODO: If you don't have anything to do, just return. */
 	// free(uninit->aux);
@@ -4,15 +4,36 @@
 #include "vm/vm.h"
 #include "vm/inspect.h"
 #include "threads/vaddr.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/trace.h"
+#include "userprog/exception.h"
 
 struct list frame_list;
 
+/* Protects FRAME_LIST, and with it the merging thread's place in
+ * the list.  A spinlock, since the merging thread holds it while it
+ * remaps other processes' pages. */
+struct spinlock frame_lock;
+
+/* An eviction runs its disk I/O outside FRAME_LOCK, with the victim
+ * marked EVICTING.  EVICT_DONE is broadcast, under EVICT_LOCK, each
+ * time one finishes, for threads that must wait for it. */
+static struct lock evict_lock;
+static struct condition evict_done;
+
+/* A frame of zeros, mapped read-only wherever an anonymous page that
+ * was never written is read.  It is never on the frame table. */
+static struct frame zero_frame;
+
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
 void vm_init(void)
 {
 	vm_anon_init();
 	vm_file_init();
+	vm_text_init();
 #ifdef EFILESYS /* For project 4 */
 	pagecache_init();
 #endif
@@ -20,6 +41,20 @@ void vm_init(void)
 	/* DO NOT MODIFY UPPER LINES. */
 	/* TODO: Your code goes here. */
 	list_init(&frame_list);
+	spin_init(&frame_lock);
+	lock_init(&evict_lock);
+	cond_init(&evict_done);
+	zero_frame.kva = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+	zero_frame.pin_cnt = 1;
+	vm_ksm_init();
+}
+
+/* Prints virtual memory statistics. */
+void vm_print_stats(void)
+{
+	ksm_print_stats();
+	zswap_print_stats();
+	anon_print_stats();
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -42,6 +77,7 @@ page_get_type(struct page *page)
 static struct frame *vm_get_victim(void);
 static bool vm_do_claim_page(struct page *page);
 static struct frame *vm_evict_frame(void);
+static bool vm_claim_huge(struct page *page, bool *success);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -80,6 +116,7 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 		/* TODO: Insert the page into the spt. */
 		if (!spt_insert_page(spt, page))
 		{
+			free(page);
 			goto err;
 		}
 	}
@@ -95,11 +132,7 @@ struct page *spt_find_page(struct supplemental_page_table *spt, void *va)
 {
 	/* TODO: supplemental_page_table에서 인자로 주어진 va에 해당되는 page를 찾아서 리턴하기 */
 
-	// struct page *page = (struct page*) malloc(sizeof(struct page));
-	struct page page;
-	page.va = pg_round_down(va);
-
-	struct hash_elem *now_elem = hash_find(&spt->hash_table, &page.spt_elem);
+	struct ohash_elem *now_elem = ohash_find(&spt->pages, (uint64_t) pg_round_down(va));
 
 	/* TODO: Fill this function. */
 	if (now_elem == NULL)
@@ -107,24 +140,18 @@ struct page *spt_find_page(struct supplemental_page_table *spt, void *va)
 		return NULL;
 	}
 
-	return hash_entry(now_elem, struct page, spt_elem);
+	return ohash_entry(now_elem, struct page, spt_elem);
 }
 
 /* Insert PAGE into spt with validation. */
 bool spt_insert_page(struct supplemental_page_table *spt,
 					 struct page *page)
 {
-	int succ = false;
 	/* TODO: Fill this function. */
 
-	struct hash_elem *exit_elem = hash_insert(&spt->hash_table, &page->spt_elem);
-
-	if (exit_elem == NULL)
-	{
-		succ = true;
-	}
-
-	return succ;
+	/* Fails on a duplicate VA, or if the table cannot grow. */
+	page->spt_elem.key = (uint64_t) page->va;
+	return ohash_insert(&spt->pages, &page->spt_elem) == OHASH_INSERTED;
 }
 
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page)
@@ -133,13 +160,38 @@ void spt_remove_page(struct supplemental_page_table *spt, struct page *page)
 	return true;
 }
 
-/* Get the struct frame, that will be evicted. */
+/* Takes F off the frame table.  FRAME_LOCK must be held. */
+static void
+frame_table_remove(struct frame *f)
+{
+	ASSERT(spin_held(&frame_lock));
+
+	ksm_forget(f);
+	list_remove(&f->list_elem);
+}
+
+/* Get the struct frame, that will be evicted.
+ * Frames are evicted in the order they were handed out, skipping
+ * frames that are pinned for an in-flight I/O transfer. */
 static struct frame *
 vm_get_victim(void)
 {
 	struct frame *victim = NULL;
-	/* TODO: The policy for eviction is up to you. */
+	struct list_elem *e;
 
+	spin_lock(&frame_lock);
+	for (e = list_begin(&frame_list); e != list_end(&frame_list); e = list_next(e))
+	{
+		struct frame *f = list_entry(e, struct frame, list_elem);
+		if (f->pin_cnt == 0)
+		{
+			victim = f;
+			victim->evicting = true;
+			frame_table_remove(f);
+			break;
+		}
+	}
+	spin_unlock(&frame_lock);
 	return victim;
 }
 
@@ -149,9 +201,52 @@ static struct frame *
 vm_evict_frame(void)
 {
 	struct frame *victim = vm_get_victim();
-	/* TODO: swap out the victim and return the evicted frame. */
 
-	return NULL;
+	if (victim == NULL)
+		return NULL;
+
+	/* Split a 2 MiB mapping now, so that swap_out() can unmap just
+	 * the victim.  Without memory for that, put the victim back. */
+	if (!pml4_split_huge_page(victim->pml4, victim->page->va))
+	{
+		lock_acquire(&evict_lock);
+		spin_lock(&frame_lock);
+		victim->evicting = false;
+		list_push_back(&frame_list, &victim->list_elem);
+		spin_unlock(&frame_lock);
+		cond_broadcast(&evict_done, &evict_lock);
+		lock_release(&evict_lock);
+		return NULL;
+	}
+
+	trace_event(TRACE_EVICT, (uint64_t)victim->page->va, (uint64_t)victim->kva);
+	// victim을 일단 디스크로 보내야해..
+	swap_out(victim->page);
+
+	lock_acquire(&evict_lock);
+	spin_lock(&frame_lock);
+	victim->evicting = false;
+	spin_unlock(&frame_lock);
+	cond_broadcast(&evict_done, &evict_lock);
+	lock_release(&evict_lock);
+
+	page_zero(victim->kva);
+	victim->page = NULL;
+	return victim;
+}
+
+/* Evicts one page and hands over its memory, for frames that live
+ * outside the frame table.  Returns NULL if nothing can be evicted. */
+void *vm_steal_page(void)
+{
+	struct frame *victim = vm_evict_frame();
+	void *kva;
+
+	if (victim == NULL)
+		return NULL;
+	kva = victim->kva;
+	free(victim);
+	return kva;
 }
 
 /* palloc() 및 get frame 사용 가능한 페이지가 없으면 해당 페이지를 퇴거하고 반환합니다.
@@ -171,26 +266,26 @@ vm_get_frame(void)
 
 	if (addr == NULL)
 	{
-
 		// printf("공간이 없어..!\n");
-		struct list_elem *out_elem = list_pop_front(&frame_list);
-		struct frame *out_frame = list_entry(out_elem, struct frame, list_elem);
-		// out_frame을 일단 디스크로 보내야해..
-		swap_out(out_frame->page);
-		memset(out_frame->kva, 0, PGSIZE);
-
-		frame = out_frame;
-		frame->page = NULL;
+		frame = vm_evict_frame();
 	}
 	else
 	{
 		frame = calloc(1, sizeof(struct frame));
-		frame->kva = addr;
+		if (frame == NULL)
+			palloc_free_page(addr);
+		else
+			frame->kva = addr;
 	}
-	list_push_back(&frame_list, &frame->list_elem);
 
-	ASSERT(frame != NULL);
+	/* Every frame is pinned, or there was no memory for the
+	 * frame itself. */
+	if (frame == NULL)
+		return NULL;
 	ASSERT(frame->page == NULL);
+	spin_lock(&frame_lock);
+	list_push_back(&frame_list, &frame->list_elem);
+	spin_unlock(&frame_lock);
 	return frame;
 }
 
@@ -201,35 +296,72 @@ vm_stack_growth(void *addr)
 {
 	// printf("stack_growth()\n");
 	struct thread *curr = thread_current();
-	void *before_buttom = curr->stack_bottom;
-
-	// if (addr < before_buttom && curr->tf.rsp > before_buttom) {
-	// 	call_exit(curr, -1);
-	// }
-	// void * check_empty = curr->tf.rsp;
-	// while (check_empty <= before_buttom) {
-	// 	//빈놈이 있으면 안돼?.?
-	// 	if (check_empty == NULL) {
-	// 		call_exit(curr, -1);
-	// 	}
-	// 	check_empty += sizeof(void *);
-	// }
 
 	curr->stack_bottom -= PGSIZE;
 
 	// printf("stack_bottom 작아졌니? %d\n", thread_current()->stack_bottom);
-	// void *before_buttom = (void *)(((uint8_t *)USER_STACK) - PGSIZE);
-	curr->tf.rsp = before_buttom;
 
 	// printf("zzz\n");
 	vm_alloc_page(VM_ANON, curr->stack_bottom, true);
 	// printf("xxx\n");
 }
 
+/* Returns true if PAGE is anonymous, untouched, and has no loader,
+ * so that its first contents are all zeros. */
+static bool
+is_zero_fill(struct page *page)
+{
+	return VM_TYPE(page->operations->type) == VM_UNINIT && page_get_type(page) == VM_ANON && page->uninit.init == NULL;
+}
+
+/* Maps the shared zero frame at PAGE, read-only.  PAGE stays uninit
+ * until its first write. */
+static bool
+vm_map_zero(struct page *page)
+{
+	if (!pml4_set_page(thread_current()->pml4, page->va, zero_frame.kva, false))
+		return false;
+	page->frame = &zero_frame;
+	return true;
+}
+
+/* Returns true if FRAME is mapped read-only into pages that are
+ * writable, to be copied on their first write. */
+static bool
+is_cow(struct frame *frame)
+{
+	return frame != NULL && (frame == &zero_frame || frame->merged);
+}
+
 /* Handle the fault on write_protected page */
 static bool
-vm_handle_wp(struct page *page UNUSED)
+vm_handle_wp(struct page *page)
 {
+	struct thread *curr = thread_current();
+	struct frame *shared = page->frame;
+	struct frame *frame;
+
+	if (!is_cow(shared))
+		return false;
+
+	/* First write to a zero page: give it a frame of its own. */
+	if (shared == &zero_frame)
+	{
+		pml4_clear_page(curr->pml4, page->va);
+		page->frame = NULL;
+		return vm_do_claim_page(page);
+	}
+
+	/* First write to a merged page: copy it back out. */
+	frame = vm_get_frame();
+	if (frame == NULL)
+		return false;
+	page_copy(frame->kva, shared->kva);
+	frame->page = page;
+	frame->pml4 = curr->pml4;
+	page->frame = frame;
+	ksm_break(shared);
+	return pml4_set_page(curr->pml4, page->va, frame->kva, page->writable);
 }
 
 /*
@@ -248,6 +380,8 @@ bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write
 
 	/* TODO: Validate the fault */
 	/* TODO: Your code goes here */
+	trace_event(TRACE_PAGE_FAULT, (uint64_t)addr,
+				(not_present ? 0 : PF_P) | (write ? PF_W : 0) | (user ? PF_U : 0));
 
 	// 구현에 도움을 드리자면 우선 인자로 들어오면 addr의 유효성을 검증하고,뒤이어 현재 쓰레드의 rsp_stack를 받아오거나 인터럽트 프레임의 rsp를 받아와 현재 쓰레드의 rsp 주소를 설정합니다.
 	if (addr == NULL || is_kernel_vaddr(addr))
@@ -288,6 +422,24 @@ bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write
 		return false;
 	}
 
+	/* Present but faulted: a write to a write-protected page. */
+	if (!not_present)
+	{
+		return vm_handle_wp(page);
+	}
+
+	/* Reading memory nobody has written yet costs no frame. */
+	if (!write && page->frame == NULL && is_zero_fill(page))
+	{
+		return vm_map_zero(page);
+	}
+
+	bool success;
+	if (vm_claim_huge(page, &success))
+	{
+		return success;
+	}
+
 	/*TODO -
 		Check if the memory reference is valid.
 		- locate the content that needs to go into the virtual memory page
@@ -316,6 +468,62 @@ void vm_dealloc_page(struct page *page)
 	free(page);
 }
 
+/* Settles PAGE's frame for a page about to be destroyed: waits for
+ * an eviction of it already under way, which leaves PAGE without a
+ * frame, and otherwise pins the frame so none can start.  Every
+ * destroy path calls this before it touches PAGE's backing store,
+ * then vm_free_frame(). */
+void vm_hold_frame(struct page *page)
+{
+	lock_acquire(&evict_lock);
+	for (;;)
+	{
+		struct frame *f;
+		bool busy;
+
+		spin_lock(&frame_lock);
+		f = page->frame;
+		busy = f != NULL && f->evicting;
+		if (f != NULL && !busy && f != &zero_frame && !f->merged)
+			f->pin_cnt++;
+		spin_unlock(&frame_lock);
+		if (!busy)
+			break;
+		cond_wait(&evict_done, &evict_lock);
+	}
+	lock_release(&evict_lock);
+}
+
+/* Unmaps PAGE and gives back the frame holding it, if any, for a
+ * page being destroyed.  vm_hold_frame() must have been called.  A private frame goes back to the user
+ * pool even when it is a slice of a 2 MiB mapping, which is split
+ * first; a shared one only loses a reference.  A slice whose mapping
+ * cannot be split for lack of memory stays mapped, and its memory
+ * goes back with the rest of the page table when the process exits. */
+void vm_free_frame(struct page *page)
+{
+	struct frame *f = page->frame;
+	bool unmapped;
+
+	if (f == NULL)
+		return;
+	unmapped = pml4_clear_page(thread_current()->pml4, page->va);
+	page->frame = NULL;
+	if (f == &zero_frame)
+		return;
+	if (f->merged)
+	{
+		ksm_put(f);
+		return;
+	}
+	spin_lock(&frame_lock);
+	frame_table_remove(f);
+	spin_unlock(&frame_lock);
+	if (unmapped)
+		palloc_free_page(f->kva);
+	free(f);
+}
+
 /* Claim the page that allocate on VA. */
 bool vm_claim_page(void *va)
 {
@@ -332,10 +540,17 @@ bool vm_claim_page(void *va)
 static bool
 vm_do_claim_page(struct page *page)
 {
+	/* Shared text brings its own frame. */
+	if (VM_TYPE(page->operations->type) == VM_TEXT)
+		return text_claim_page(page);
+
 	struct frame *frame = vm_get_frame();
+	if (frame == NULL)
+		return false;
 
 	/* Set links */
 	frame->page = page;
+	frame->pml4 = thread_current()->pml4;
 	page->frame = frame;
 
 	/* TODO: Insert page table entry to map page's VA to frame's PA. */
@@ -352,19 +567,168 @@ vm_do_claim_page(struct page *page)
 		return false;
 	}
 
-	return swap_in(page, frame->kva);
+	/* Keep the ksm thread off the frame until it is filled. */
+	frame->pin_cnt++;
+	bool success = swap_in(page, frame->kva);
+	frame->pin_cnt--;
+	return success;
+}
+
+/* Returns true if the page at VA is one vm_claim_huge() may back:
+ * present in SPT, untouched, anonymous or file-backed, and mapped
+ * with permission WRITABLE. */
+static bool
+huge_candidate(struct supplemental_page_table *spt, void *va, bool writable)
+{
+	struct page *page = spt_find_page(spt, va);
+	enum vm_type type;
+
+	if (page == NULL || VM_TYPE(page->operations->type) != VM_UNINIT || page->frame != NULL || page->writable != writable)
+		return false;
+	type = page_get_type(page);
+	return type == VM_ANON || type == VM_FILE;
+}
+
+/* Tries to fault in the whole 2 MiB-aligned region around PAGE at
+ * once, backed by one 2 MiB mapping.  The region must be made up of
+ * untouched pages that all agree on permissions, and the user pool
+ * must have 2 MiB of aligned free memory.  Each page keeps its own
+ * struct page and gets a 4 KiB slice as its frame, so the usual
+ * per-page code still works; the MMU splits the mapping when any of
+ * it is unmapped, evicted or remapped.  Returns false, having done
+ * nothing, if any of that does not hold; otherwise returns true and
+ * sets *SUCCESS to whether the pages could be loaded. */
+static bool
+vm_claim_huge(struct page *page, bool *success)
+{
+	struct thread *curr = thread_current();
+	struct supplemental_page_table *spt = &curr->spt;
+	uint8_t *base = (uint8_t *)((uint64_t)page->va & ~(HPAGE_SIZE - 1));
+	struct list frames;
+	uint8_t *kva;
+	size_t i;
+
+	/* The ends rule out most regions cheaply. */
+	if (!huge_candidate(spt, base, page->writable) || !huge_candidate(spt, base + HPAGE_SIZE - PGSIZE, page->writable))
+		return false;
+	for (i = 1; i < HPAGE_PGCNT - 1; i++)
+		if (!huge_candidate(spt, base + i * PGSIZE, page->writable))
+			return false;
+
+	/* Get every frame struct up front, so that running out of
+	 * memory leaves nothing to undo but these and the block. */
+	list_init(&frames);
+	for (i = 0; i < HPAGE_PGCNT; i++)
+	{
+		struct frame *frame = calloc(1, sizeof *frame);
+		if (frame == NULL)
+			goto fail;
+		list_push_back(&frames, &frame->list_elem);
+	}
+
+	kva = palloc_get_aligned(PAL_USER | PAL_ZERO, HPAGE_PGCNT);
+	if (kva == NULL)
+		goto fail;
+	if (!pml4_set_huge_page(curr->pml4, base, kva, page->writable))
+	{
+		palloc_free_multiple(kva, HPAGE_PGCNT);
+		goto fail;
+	}
+
+	/* Each slice stays pinned until it is loaded, so that neither
+	 * the evictor nor ksm takes it half-filled. */
+	spin_lock(&frame_lock);
+	for (i = 0; i < HPAGE_PGCNT; i++)
+	{
+		struct page *p = spt_find_page(spt, base + i * PGSIZE);
+		struct frame *frame = list_entry(list_pop_front(&frames), struct frame, list_elem);
+
+		frame->kva = kva + i * PGSIZE;
+		frame->page = p;
+		frame->pml4 = curr->pml4;
+		frame->pin_cnt = 1;
+		p->frame = frame;
+		list_push_back(&frame_list, &frame->list_elem);
+	}
+	spin_unlock(&frame_lock);
+	*success = true;
+	for (i = 0; i < HPAGE_PGCNT; i++)
+	{
+		struct page *p = spt_find_page(spt, base + i * PGSIZE);
+		struct frame *frame = p->frame;
+
+		if (*success && !swap_in(p, frame->kva))
+			*success = false;
+		frame->pin_cnt--;
+	}
+	return true;
+
+fail:
+	while (!list_empty(&frames))
+		free(list_entry(list_pop_front(&frames), struct frame, list_elem));
+	return false;
+}
+
+/* Makes every page of the user buffer [BUFFER, BUFFER + SIZE)
+ * resident and pins its frame, so that the frame is not evicted
+ * while a device transfers data into or out of it in place.  Pins
+ * nest: a frame stays put until each pin on it is released.
+ * Returns false, with nothing left pinned, if part of the buffer
+ * is unmapped, WRITE is true and part of it is read-only, or no
+ * frame can be found for it. */
+bool vm_pin_buffer(const void *buffer, size_t size, bool write)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	void *start = pg_round_down(buffer);
+	void *upage;
+
+	for (upage = start; upage < buffer + size; upage += PGSIZE)
+	{
+		struct page *page = spt_find_page(spt, upage);
+
+		/* The device writes behind the MMU's back, so a shared page
+		 * must get its own frame first. */
+		if (page != NULL && write && page->writable && is_cow(page->frame) && !vm_handle_wp(page))
+			page = NULL;
+
+		if (page == NULL || (write && !page->writable) || (page->frame == NULL && !vm_do_claim_page(page)))
+		{
+			vm_unpin_buffer(start, upage - start);
+			return false;
+		}
+		page->frame->pin_cnt++;
+	}
+	return true;
+}
+
+/* Releases the pins taken by vm_pin_buffer() on the user buffer
+ * [BUFFER, BUFFER + SIZE). */
+void vm_unpin_buffer(const void *buffer, size_t size)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	void *upage;
+
+	for (upage = pg_round_down(buffer); upage < buffer + size; upage += PGSIZE)
+	{
+		struct page *page = spt_find_page(spt, upage);
+		if (page != NULL && page->frame != NULL)
+		{
+			ASSERT(page->frame->pin_cnt > 0);
+			page->frame->pin_cnt--;
+		}
+	}
 }
 
 /* Initialize new supplemental page table */
 void supplemental_page_table_init(struct supplemental_page_table *spt)
 {
-	hash_init(&spt->hash_table, page_hash, page_less, NULL);
+	ohash_init(&spt->pages);
 }
 
 /* Copy supplemental page table from src to dst */
 bool supplemental_page_table_copy(struct supplemental_page_table *dst, struct supplemental_page_table *src)
 {
-	hash_apply(&src->hash_table, page_hash_copy);
+	ohash_apply(&src->pages, page_hash_copy);
 	return true;
 }
 
@@ -374,54 +738,42 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt)
 	/* TODO: Destroy all the supplemental_page_table hold by thread and
 	 * TODO: writeback all the modified contents to the storage. */
 
-	// hash_apply(&spt->hash_table, page_kill);
-
-	hash_destroy(spt, page_hash_destructor); // page, frame 관련 리소스 해제 / 버킷 리스트 해제
-}
-
-/* Returns a hash value for page p. */
-unsigned page_hash(const struct hash_elem *p_, void *aux)
-{
-	const struct page *p = hash_entry(p_, struct page, spt_elem);
-	return hash_bytes(&p->va, sizeof p->va);
-}
-
-bool page_less(const struct hash_elem *a_,
-			   const struct hash_elem *b_, void *aux)
-{
-	const struct page *a = hash_entry(a_, struct page, spt_elem);
-	const struct page *b = hash_entry(b_, struct page, spt_elem);
+	// ohash_apply(&spt->pages, page_kill);
 
-	return a->va < b->va;
+	ohash_destroy(&spt->pages, page_hash_destructor); // page, frame 관련 리소스 해제 / 슬롯 배열 해제
 }
 
-void page_hash_destructor(struct hash_elem *e, void *aux)
+void page_hash_destructor(struct ohash_elem *e)
 {
-	struct page *page = hash_entry(e, struct page, spt_elem);
+	struct page *page = ohash_entry(e, struct page, spt_elem);
 	vm_dealloc_page(page);
 }
 
-void page_hash_copy(struct hash_elem *src_elem, void *aux)
+void page_hash_copy(struct ohash_elem *src_elem)
 {
-	struct page *src_p = hash_entry(src_elem, struct page, spt_elem);
+	struct page *src_p = ohash_entry(src_elem, struct page, spt_elem);
 
 	if (src_p->operations->type == VM_UNINIT)
 	{
 		vm_alloc_page_with_initializer(VM_ANON, src_p->va, src_p->writable, src_p->uninit.init, src_p->uninit.aux);
 	}
+	else if (VM_TYPE(src_p->operations->type) == VM_TEXT)
+	{
+		vm_alloc_text_page(src_p->va, src_p->text.shared);
+	}
 	else
 	{
 		vm_alloc_page(src_p->operations->type, src_p->va, src_p->writable);
 		vm_claim_page(src_p->va);
 		struct page *child_page = spt_find_page(&thread_current()->spt, src_p->va);
 		if (src_p->frame != NULL)
-			memcpy(child_page->frame->kva, src_p->frame->kva, PGSIZE);
+			page_copy(child_page->frame->kva, src_p->frame->kva);
 	}
 }
 
-void page_kill(struct hash_elem *elem, void *aux)
+void page_kill(struct ohash_elem *elem)
 {
-	struct page *page = hash_entry(elem, struct page, spt_elem);
+	struct page *page = ohash_entry(elem, struct page, spt_elem);
 
 	// VM_FILE
 	// if (page->operations->type == VM_FILE)
@@ -429,12 +781,6 @@ void page_kill(struct hash_elem *elem, void *aux)
 	// 	do_munmap(page->va);
 	// }
 
-	struct frame *f = page->frame;
-	if (f != NULL)
-	{
-		pml4_clear_page(thread_current()->pml4, page->va);
-		list_remove(&f->list_elem);
-		palloc_free_page(f->kva);
-		free(f);
-	}
+	vm_hold_frame(page);
+	vm_free_frame(page);
 }
\ No newline at end of file
@@ -0,0 +1,204 @@
+/* zswap.c: Compressed cache in front of the swap disk.
+ *
+ * Evicted anonymous pages are compressed into a fixed arena of
+ * kernel pages, cut into ZSWAP_CHUNK-byte chunks.  Swapping such a
+ * page back in is a decompression instead of a disk read.  When the
+ * arena is full, the pages that have been in it longest are
+ * decompressed and written out to the swap disk to make room.  Pages
+ * that do not shrink to ZSWAP_MAX_LEN go straight to disk. */
+
+#include "vm/vm.h"
+#include "vm/zswap.h"
+#include <bitmap.h>
+#include <lz.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/synch.h"
+
+/* Size of the arena, in pages. */
+#define ZSWAP_ARENA_PAGES 64
+
+/* Unit of arena allocation. */
+#define ZSWAP_CHUNK 64
+#define ZSWAP_CHUNK_CNT (ZSWAP_ARENA_PAGES * PGSIZE / ZSWAP_CHUNK)
+
+/* Largest compressed page worth keeping. */
+#define ZSWAP_MAX_LEN (PGSIZE / 2)
+
+/* One compressed page. */
+struct zswap_entry {
+	struct list_elem elem;  /* lru list. */
+	struct page *page;      /* Swapped-out page it holds. */
+	uint64_t *pml4;         /* Page table of PAGE's process. */
+	size_t chunk;           /* First chunk in the arena. */
+	size_t len;             /* Compressed size in bytes. */
+};
+
+static uint8_t *arena;
+static struct bitmap *used_chunks;
+
+/* Entries, oldest first. */
+static struct list lru;
+
+/* Protects everything above, and the buffers below. */
+static struct lock zswap_lock;
+
+static void *work;       /* lz_compress() match table. */
+static void *cbuf;       /* Compressed output. */
+static void *pbuf;       /* A page decompressed for spilling. */
+
+static long long stores;       /* Pages compressed into the arena. */
+static long long rejects;      /* Pages that did not compress enough. */
+static long long hits;         /* Swap-ins served from the arena. */
+static long long misses;       /* Swap-ins that had to read the disk. */
+static long long spills;       /* Pages moved from the arena to disk. */
+static long long bytes_in;     /* Uncompressed size of all stores. */
+static long long bytes_out;    /* Compressed size of all stores. */
+
+/* Sets up the arena.  Leaves zswap off if memory is short. */
+void vm_zswap_init(void)
+{
+	lock_init(&zswap_lock);
+	list_init(&lru);
+
+	arena = palloc_get_multiple(0, ZSWAP_ARENA_PAGES);
+	used_chunks = bitmap_create(ZSWAP_CHUNK_CNT);
+	work = palloc_get_page(0);
+	cbuf = palloc_get_page(0);
+	pbuf = palloc_get_page(0);
+	if (arena == NULL || used_chunks == NULL || work == NULL || cbuf == NULL || pbuf == NULL)
+	{
+		printf("zswap: not enough memory, disabled\n");
+		arena = NULL;
+	}
+}
+
+/* Frees E's chunks and E itself. */
+static void
+entry_free(struct zswap_entry *e)
+{
+	ASSERT(lock_held_by_current_thread(&zswap_lock));
+
+	bitmap_set_multiple(used_chunks, e->chunk, DIV_ROUND_UP(e->len, ZSWAP_CHUNK), false);
+	list_remove(&e->elem);
+	e->page->anon.zentry = NULL;
+	free(e);
+}
+
+/* Moves the oldest page in the arena out to the swap disk.  Returns
+ * false if the arena is empty. */
+static bool
+spill_oldest(void)
+{
+	struct zswap_entry *e;
+	struct page *page;
+	uint64_t *pml4;
+
+	if (list_empty(&lru))
+		return false;
+
+	e = list_entry(list_front(&lru), struct zswap_entry, elem);
+	page = e->page;
+	pml4 = e->pml4;
+	if (lz_decompress(arena + e->chunk * ZSWAP_CHUNK, e->len, pbuf, PGSIZE) != PGSIZE)
+		PANIC("zswap: corrupt entry for page %p", page->va);
+	entry_free(e);
+	anon_swap_write(page, pbuf, pml4);
+	spills++;
+	return true;
+}
+
+/* Compresses the contents of PAGE, at KVA, into the arena, making
+ * room if need be.  Returns false if the page should be written to
+ * the swap disk instead. */
+bool zswap_store(struct page *page, const void *kva)
+{
+	struct zswap_entry *e;
+	size_t len, chunk_cnt, chunk;
+
+	if (arena == NULL)
+		return false;
+	e = malloc(sizeof *e);
+	if (e == NULL)
+		return false;
+
+	lock_acquire(&zswap_lock);
+	len = lz_compress(kva, PGSIZE, cbuf, ZSWAP_MAX_LEN, work);
+	if (len == 0)
+	{
+		rejects++;
+		lock_release(&zswap_lock);
+		free(e);
+		return false;
+	}
+
+	chunk_cnt = DIV_ROUND_UP(len, ZSWAP_CHUNK);
+	while ((chunk = bitmap_scan_and_flip(used_chunks, 0, chunk_cnt, false)) == BITMAP_ERROR)
+		if (!spill_oldest())
+		{
+			lock_release(&zswap_lock);
+			free(e);
+			return false;
+		}
+
+	memcpy(arena + chunk * ZSWAP_CHUNK, cbuf, len);
+	e->page = page;
+	e->pml4 = page->frame->pml4;
+	e->chunk = chunk;
+	e->len = len;
+	list_push_back(&lru, &e->elem);
+	page->anon.zentry = e;
+
+	stores++;
+	bytes_in += PGSIZE;
+	bytes_out += len;
+	lock_release(&zswap_lock);
+	return true;
+}
+
+/* Decompresses PAGE into KVA and drops it from the arena.  Returns
+ * false if PAGE is not in the arena, so it is on the swap disk. */
+bool zswap_load(struct page *page, void *kva)
+{
+	struct zswap_entry *e;
+
+	if (arena == NULL)
+		return false;
+
+	lock_acquire(&zswap_lock);
+	e = page->anon.zentry;
+	if (e == NULL)
+	{
+		misses++;
+		lock_release(&zswap_lock);
+		return false;
+	}
+	if (lz_decompress(arena + e->chunk * ZSWAP_CHUNK, e->len, kva, PGSIZE) != PGSIZE)
+		PANIC("zswap: corrupt entry for page %p", page->va);
+	entry_free(e);
+	hits++;
+	lock_release(&zswap_lock);
+	return true;
+}
+
+/* Forgets PAGE's compressed copy, if it has one. */
+void zswap_drop(struct page *page)
+{
+	if (arena == NULL)
+		return;
+
+	lock_acquire(&zswap_lock);
+	if (page->anon.zentry != NULL)
+		entry_free(page->anon.zentry);
+	lock_release(&zswap_lock);
+}
+
+/* Prints compressed swap statistics. */
+void zswap_print_stats(void)
+{
+	printf("Zswap: %lld pages stored at %lld%% of their size, %lld rejected, %lld spilled\n",
+		   stores, bytes_in ? bytes_out * 100 / bytes_in : 0, rejects, spills);
+	printf("Zswap: %lld of %lld swap-ins hit\n", hits, hits + misses);
+}